@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -7,6 +8,15 @@
 #include <fcntl.h>
 #include <time.h>
 #include <math.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <stddef.h>
 
 // directory of the analyzer file
 #define DIRECTORY_ANALYSIS_REPORT "RBM_Report_G23_analysis.txt"
@@ -15,115 +25,295 @@
 #define WORD_CHAR_LIMIT 25
 // the word limit of a command
 #define COMMAND_CHAR_SIZE 80
-// the maximum command can stored in the system
-#define MAX_COMMAND 300
+// the maximum number of words in a command
+#define COMMAND_WORD_LIMIT 10
+// the maximum number of bookings stored in the system, only address space is reserved for them
+#define BOOKING_STORE_CAPACITY (1 << 24)
 // directory of the output file
 #define DIRECTORY_OUTPUT_PREFIX "RBM_Report_G23_out"
 
 //  -- Common Data --
-// Tenants, rooms, and facilities
+// Tenants, rooms, and facilities come from the catalog, loaded once before the modules are forked
+// each line of the catalog file is a kind and a name:
+//     tenant <name>
+//     room <name> <capacity>
+//     webcam|monitor|projector|screen <name> <number of units>
+// device units with the same name are one device model
 // EACH NAME CANNOT EXCCED WORD_CHAR_LIMIT
-const char *tenantNames[] = {"tenant_A", "tenant_B", "tenant_C", "tenant_D", "tenant_E"};
-const char *roomNames[] = {"room_A", "room_B", "room_C"};
-const char *webcamNames[] = {"webcam_FHD", "webcam_FHD", "webcam_UHD"};
-const char *monitorNames[] = {"monitor_50", "monitor_50", "monitor_75"};
-const char *projectorNames[] = {"projector_2K", "projector_2K", "projector_4K"};
-const char *screenNames[] = {"screen_100", "screen_100", "screen_150"};
-
-const int roomCapacity[] = {10, 10, 20};
-
-#define tenantAmount (sizeof(tenantNames) / sizeof(const char *))
-#define roomAmount (sizeof(roomNames) / sizeof(const char *))
-#define webcamAmount (sizeof(webcamNames) / sizeof(const char *))
-#define monitorAmount (sizeof(monitorNames) / sizeof(const char *))
-#define projectorAmount (sizeof(projectorNames) / sizeof(const char *))
-#define screenAmount (sizeof(screenNames) / sizeof(const char *))
-
-#define SCHEDULE_STRING_LENGTH 10 * 7 + (roomAmount + webcamAmount + monitorAmount + projectorAmount + screenAmount) * 24 * 7
-
-// scedule data (10-05-2021 to 16-05-2021)
-
-// FORMAT:
-//[DATE(length:10)][room_A schedule(length:24)][room_B schedule]...[webcam[0] schedule(length: 24)]...[monitor, project, screen]
-//(repeat after all room/device schedule is inserted on a single date)[next DATE]...
-
-// EXPLAIN:
-// in room/device each schedule: 24 hour is 24 char, if no one used on that time, '_' is insert
-// if someone is used, insert the tenant index in tenantNames
-
-// sample schedule:
-// 10-05-2021__000___111___123...(until finish the room_A schedule)[all room schedule][all device schedule...]
-// note: device type schedule order: webcam, monitor, projector, screen
-// note: on each device type: the order of device schedule is listed in [XXX]Names (start from line 21)
-
-char fcfs[SCHEDULE_STRING_LENGTH];
-char priority[SCHEDULE_STRING_LENGTH];
-int fcfsRejectedCount = 0;
-int fcfsRejectedCommandIndex[MAX_COMMAND];
-int priorityRejectedCount = 0;
-int priorityRejectedCommandIndex[MAX_COMMAND];
 
-//  -- Utility functions --
-// find number of word in a string (seperate by space)
-// ASSUMING NO SPACE FORMAT ERROR
-int getNumOfWord(char *command, int numOfChar)
+// directory of the catalog file, the built-in catalog is used if it does not exist
+#define DIRECTORY_CATALOG "RBM_catalog.txt"
+// the maximum number of rooms and device units together
+#define CATALOG_UNIT_LIMIT 4095
+// the maximum number of tenants
+#define CATALOG_TENANT_LIMIT 65535
+
+// type of a calendar resource, the units of a catalog are in this order
+typedef enum
 {
-    int i, wordCount = 0;
-    int isPreviousSpace = 1;
-    for (i = 0; i < numOfChar; i++)
-    {
-        if (command[i] == ' ')
-        {
-            isPreviousSpace = 1;
-        }
-        else if (isPreviousSpace == 1)
-        {
-            isPreviousSpace = 0;
-            wordCount++;
-        }
-    }
-    return wordCount;
-}
+    roomResource,
+    webcamResource,
+    monitorResource,
+    projectorResource,
+    screenResource,
+} resource_type;
 
-// split whole command to a string array (seperate by space), delete ';'
-// ASSUMING NO SPACE FORMAT ERROR
-// !!! REMEMBER to free the memory after using the return value
-char **splitCommand(char *command, int numOfChar)
+// kind of each catalog line, by resource_type
+const char *resourceKindNames[] = {"room", "webcam", "monitor", "projector", "screen"};
+
+// the catalog used without a catalog file
+const char defaultCatalog[] =
+    "tenant tenant_A\ntenant tenant_B\ntenant tenant_C\ntenant tenant_D\ntenant tenant_E\n"
+    "room room_A 10\nroom room_B 10\nroom room_C 20\n"
+    "webcam webcam_FHD 2\nwebcam webcam_UHD 1\n"
+    "monitor monitor_50 2\nmonitor monitor_75 1\n"
+    "projector projector_2K 2\nprojector projector_4K 1\n"
+    "screen screen_100 2\nscreen screen_150 1\n";
+
+// the catalog as arrays, one entry per tenant or per unit
+typedef struct resourceCatalog
 {
-    int i, wordCount = getNumOfWord(command, numOfChar);
-    // printf("Function 'splitCommand': wordCount = %d\n", wordCount);
-    char **words = malloc(wordCount * sizeof(char *));
-    for (i = 0; i < wordCount; i++)
-    {
-        words[i] = malloc(WORD_CHAR_LIMIT * sizeof(char));
-    }
-    char tempWord[25];
-    int tempWordCount = 0;
-    int tempCharCount = 0;
-    for (i = 0; i < numOfChar; i++)
+    int tenantAmount;
+    const char **tenantNames;
+    // every unit, by resource_type
+    int resourceAmount;
+    // calendar index of the first unit of each resource_type, then resourceAmount
+    int typeStart[screenResource + 2];
+    const char **resourceNames;
+    // capacity of each room
+    int *roomCapacity;
+    // the catalog text, the names point into it
+    char *text;
+} resourceCatalog;
+
+resourceCatalog catalog;
+
+#define tenantAmount (catalog.tenantAmount)
+#define resourceAmount (catalog.resourceAmount)
+
+//  -- Occupancy calendar --
+// the scheduling module keeps its schedules as one interval index per resource:
+// each booking holds one interval [start, end) of absolute hours on each of its resources,
+// intervals of a resource never overlap, so they are kept ordered by start in a treap
+// and an overlap test is one predecessor search, whatever the length of the booking or the horizon
+
+// first day a booking can use (0000-01-01), in days since 1970-01-01
+#define CALENDAR_FIRST_DAY (-719528)
+// number of days a booking can use (0000-01-01 to 9999-12-31)
+#define CALENDAR_DAYS 3652425
+// number of hours in a day
+#define DAY_HOURS 24
+// the maximum number of intervals on one calendar, a booking holds a room and up to two devices
+#define CALENDAR_NODE_CAPACITY ((MAX_BOOKING_DEVICE + 1) * BOOKING_STORE_CAPACITY + 1)
+
+// index of the first unit of each type in the calendar, in the order of the catalog
+#define roomResourceStart (catalog.typeStart[roomResource])
+#define webcamResourceStart (catalog.typeStart[webcamResource])
+#define monitorResourceStart (catalog.typeStart[monitorResource])
+#define projectorResourceStart (catalog.typeStart[projectorResource])
+#define screenResourceStart (catalog.typeStart[screenResource])
+
+#define roomAmount (webcamResourceStart - roomResourceStart)
+#define webcamAmount (monitorResourceStart - webcamResourceStart)
+#define monitorAmount (projectorResourceStart - monitorResourceStart)
+#define projectorAmount (screenResourceStart - projectorResourceStart)
+#define screenAmount (resourceAmount - screenResourceStart)
+
+// an interval held by a booking on a resource
+// the nodes are linked by their index in the node array, 0 is the empty tree
+typedef struct intervalNode
+{
+    // hours since 1970-01-01 00:00
+    int start;
+    int end;
+    // command index holding the interval, -1 if the node is free
+    int command;
+    short resource;
+    // priority of the command holding the interval
+    char priority;
+    int left;
+    int right;
+    // next interval held by the same command, 0 if it is the last
+    int nextHeld;
+} intervalNode;
+
+// the nodes are reserved with MAP_NORESERVE before forking,
+// so memory is only used for the intervals in use
+typedef struct calendar
+{
+    // tree of each resource, shared like the nodes
+    int *root;
+    intervalNode *nodes;
+    // nodes used so far, node 0 is never used
+    int nodeCount;
+    // erased nodes, linked through right
+    int freeNode;
+    // first interval held by each command, 0 if none
+    int *heldBy;
+} calendar;
+
+//  -- Shared schedules --
+// mapped by the parent before forking, so all modules see the same pages:
+// the scheduling module places bookings in it, output and analyzer read the calendars in place
+// the parent waits for output and analyzer before forwarding the next booking,
+// so the scheduling module never changes it while it is read
+
+// the maximum number of scheduling policies
+#define POLICY_LIMIT 8
+
+// the schedule kept by one policy
+typedef struct policySchedule
+{
+    calendar cal;
+    int rejectedCount;
+    // in the booking store, in the order they were rejected
+    // a booking admitted again or withdrawn leaves a stale entry, which compactRejected drops
+    int *rejectedCommandIndex;
+    int staleCount;
+    // entries placed that are not standing bookings: cancellations, and bookings cancelled or moved
+    int withdrawn;
+    // in the booking store, the assignment of each booking id
+    struct assignment *assigned;
+} policySchedule;
+
+typedef struct sharedSchedule
+{
+    // increased by the scheduling module on each printBookings,
+    // the readers check it matches the generation the parent passed on
+    unsigned int generation;
+    // bookings [0, placed) are on every schedule, raised by the scheduling module
+    // after each message of bookings, with the online admission answering from it
+    int placed;
+    // in the order of policies
+    policySchedule schedules[POLICY_LIMIT];
+} sharedSchedule;
+
+//  -- Bookings --
+// the input module parses each booking command once,
+// the other modules pass the fixed size booking around instead of the text
+
+// type of a booking, the value is also its priority
+typedef enum
+{
+    none,
+    bookDevice,
+    addMeeting,
+    addPresentation,
+    addConference,
+    // cancels the booking it copies, never placed
+    cancelBooking,
+} event_priority;
+
+// command name of each type
+const char *eventNames[] = {"", "bookDevice", "addMeeting", "addPresentation", "addConference", "cancelBooking"};
+
+// the maximum number of devices in a booking
+#define MAX_BOOKING_DEVICE 2
+
+// the booking store is one shared mapping reserved before forking with MAP_NORESERVE,
+// memory is only used for the pages that are written, so it grows in place without copying
+// a booking id is its index in the store and never changes
+// the input module appends the bookings, the other modules read them by id
+// cancelBooking and moveBooking are appended too, as a copy of the booking they change:
+// a cancellation with the type cancelBooking, a move with its new hours, which is the booking from then on
+// if its hours fit on the schedule, otherwise the move is rejected and the booking stays as it was
+
+typedef struct booking
+{
+    // event_priority of the command
+    unsigned char type;
+    unsigned char deviceCount;
+    // index in the tenants of the catalog
+    unsigned short tenant;
+    // device model: calendar index of the first unit with the requested name
+    unsigned short device[MAX_BOOKING_DEVICE];
+    // number of participants, 0 for bookDevice
+    short participants;
+    // minutes after midnight
+    short startMinute;
+    // length in minutes
+    short duration;
+    // days since 1970-01-01
+    int day;
+    // 1 + id of the booking this one cancels or moves, 0 for a new booking
+    // it is the id of the first command of the booking, its moves only stand for it
+    int target;
+} booking;
+
+// where a booking ended up on one schedule, written by the scheduling module
+// the output module prints from it, without looking for the booking in the calendar
+typedef struct assignment
+{
+    // index in the rooms of the catalog, -1 for bookDevice
+    short room;
+    // calendar index of the unit given for each device of the booking
+    short device[MAX_BOOKING_DEVICE];
+    // 1 if the booking holds its resources
+    char accepted;
+    // command that displaced the booking, -1 if it was rejected on arrival
+    int evictedBy;
+    // index in the rejected list while the booking is rejected, -1 otherwise
+    int rejectedAt;
+    // last booking displaced by this one, -1 if none, the others follow through nextDisplaced
+    int displaced;
+    int nextDisplaced;
+    // for a new booking, the command it stands as on the schedule: itself or the move that fit last, -1 once cancelled
+    int current;
+} assignment;
+
+//  -- Name lookup --
+// tenant and device names are resolved through one open addressing hash table,
+// built from the name tables before the modules are forked
+
+// kind of a name in the table
+typedef enum
+{
+    tenantName,
+    deviceName,
+} name_kind;
+
+typedef struct nameEntry
+{
+    // NULL if the slot is empty
+    const char *name;
+    unsigned int hash;
+    int kind;
+    // tenant index or device model
+    int id;
+} nameEntry;
+
+// power of two with at most half of the slots used
+nameEntry *nameTable = NULL;
+unsigned int nameTableMask = 0;
+// device model of each device unit
+int *resourceModel = NULL;
+
+//  -- Utility functions --
+// split a command to words in place (seperate by space), the ';' ends the command
+// return the number of words, only the first maxWords are stored in words
+int splitWords(char *command, char **words, int maxWords)
+{
+    int wordCount = 0;
+    char *p = command;
+    while (*p != 0 && *p != ';')
     {
-        if (command[i] == ' ')
+        if (*p == ' ' || *p == '\t' || *p == '\r')
         {
-            words[tempWordCount][tempCharCount] = 0;
-            tempWordCount++;
-            tempCharCount = 0;
+            *p++ = 0;
+            continue;
         }
-        else if (command[i] == ';')
+        if (wordCount < maxWords)
         {
-            words[tempWordCount][tempCharCount] = 0;
-            break;
+            words[wordCount] = p;
         }
-        else
+        wordCount++;
+        while (*p != 0 && *p != ';' && *p != ' ' && *p != '\t' && *p != '\r')
         {
-            words[tempWordCount][tempCharCount] = command[i];
-            tempCharCount++;
+            p++;
         }
     }
-    for (i = 0; i < wordCount; i++)
-    {
-        // printf("Function 'splitCommand': word[%d] = %s\n", i, words[i]);
-    }
-    return words;
+    *p = 0;
+    return wordCount;
 }
 
 // convert int to string
@@ -136,1467 +326,4721 @@ char *getStringFromInt(int number)
     return result;
 }
 
-// convert string to int
-int getIntFromString(char *str)
+//  -- Booking functions --
+// days since 1970-01-01 of a date (Gregorian calendar)
+int daysFromCivil(int year, int month, int day)
 {
-    return strtol(str, NULL, 10);
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
 }
 
-int charToInt(char c)
+// date of the days since 1970-01-01
+void civilFromDays(int days, int *year, int *month, int *day)
 {
-    int num = 0;
-
-    //Substract '0' from entered char to get
-    //corresponding digit
-    num = c - '0';
-
-    return num;
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    *day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    *year = yearOfEra + era * 400 + (*month <= 2);
 }
 
-int main()
+// value of exactly count digits, -1 if any of them is not a digit
+int readDigits(const char *str, int count)
 {
-    printf("~~ WELCOME TO PolySME ~~ \n");
-    // STEP 1: fork and pipe for INPUT MODULE
-    int inputPipe[2][2];
-    pid_t inputCid;
-    // create pipe, parent use [0][1] write, child use [1][1] write
-    int i;
-    for (i = 0; i < 2; i++)
+    int i, value = 0;
+    for (i = 0; i < count; i++)
     {
-        if (pipe(inputPipe[i]) < 0)
+        if (str[i] < '0' || str[i] > '9')
         {
-            printf("Error: Pipe creation error\n");
-            exit(1);
+            return -1;
         }
+        value = value * 10 + str[i] - '0';
     }
+    return value;
+}
 
-    // create INPUT MODULE child process
-    if ((inputCid = fork()) < 0)
+// YYYY-MM-DD to days since 1970-01-01, return 0 if invalid
+int parseDate(const char *str, int *days)
+{
+    const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (strlen(str) != 10 || str[4] != '-' || str[7] != '-')
     {
-        printf("Error: fork input module error\n");
-        exit(1);
+        return 0;
     }
-    else if (inputCid == 0)
+    int year = readDigits(str, 4);
+    int month = readDigits(str + 5, 2);
+    int day = readDigits(str + 8, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1)
     {
-        // INPUT MODULE
-        close(inputPipe[1][0]);
-        close(inputPipe[0][1]);
-        // printf("Input Moudle: Started.\n");
-
-        char buf[COMMAND_CHAR_SIZE];
-        char parentBuf[COMMAND_CHAR_SIZE];
-        FILE *infilep = NULL;
-        int invalid = 0;
-        int n;
-        int startBatch = 0;
-        char **words;
-        int wordCount;
-        while (1)
-        {
-            if (invalid == 1)
-            {
-                write(inputPipe[1][1], "INVALID", COMMAND_CHAR_SIZE);
-                invalid = 0;
-            }
-            // Read Input
-            int i;
-            // printf("Input Moudle: infilep = %d.\n", infilep == NULL);
-            if (infilep == NULL)
-            {
-                n = read(inputPipe[0][0], parentBuf, COMMAND_CHAR_SIZE);
-                parentBuf[n] = 0;
-                if (strcmp(parentBuf, "PROMPT") == 0)
-                {
-                    // read from stdin
-                    printf("Please enter booking:\n");
-                    n = read(STDIN_FILENO, buf, COMMAND_CHAR_SIZE);
-                    if (n <= 1)
-                    {
-                        printf("Input Module Error: entering empty line\n");
-                        invalid = 1;
-                        continue;
-                    }
-                    buf[--n] = 0;
-                    // printf("Input Module: %d char in input line: [%s]\n", n, buf);
-                }
-                else
-                {
-                    printf("Input Error: unexpected pipe [%s]\n", buf);
-                }
-            }
-            else
-            {
-                // read from file
-                if (fgets(buf, COMMAND_CHAR_SIZE - 1, infilep))
-                {
-                    if (startBatch == 1)
-                    {
-                        buf[strcspn(buf, "\n")] = 0;
-                        n = strlen(buf);
-                        startBatch = 0;
-                    }
-                    else
-                    {
-                        n = read(inputPipe[0][0], parentBuf, COMMAND_CHAR_SIZE);
-                        parentBuf[n] = 0;
-                        if (strcmp(parentBuf, "PROMPT") == 0)
-                        {
-                            buf[strcspn(buf, "\n")] = 0;
-                            n = strlen(buf);
-                            // printf("Input Modul: batch read line %s: %d\n", buf, n);
-                        }
-                    }
-                }
-                else
-                {
-                    fclose(infilep);
-                    infilep = NULL;
-                    continue;
-                }
-            }
+        return 0;
+    }
+    int isLeap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    if (day > monthDays[month - 1] + (month == 2 && isLeap))
+    {
+        return 0;
+    }
+    *days = daysFromCivil(year, month, day);
+    return 1;
+}
 
-            // Error handling
-            // can handle: wrong word count, wrong tenant name, wrong device name
-            words = splitCommand(buf, n);
-            wordCount = getNumOfWord(buf, n);
-            int deviceIndex = -1;
-            if (strcmp(words[0], "addMeeting") == 0)
-            {
-                words[1]++;
-                deviceIndex = 6;
-            }
-            else if (strcmp(words[0], "addPresentation") == 0)
-            {
-                words[1]++;
-                deviceIndex = 6;
-            }
-            else if (strcmp(words[0], "addConference") == 0)
-            {
-                words[1]++;
-                deviceIndex = 6;
-            }
-            else if (strcmp(words[0], "bookDevice") == 0)
-            {
-                words[1]++;
-                deviceIndex = 5;
-            }
-            // word check
-            if (deviceIndex != -1)
-            {
-                if (wordCount < deviceIndex)
-                {
-                    printf("Input Module Error: must have at least %d words\n", deviceIndex);
-                    invalid = 1;
-                    continue;
-                }
-                // tenant name check
-                int valid = 0;
-                for (i = 0; i < tenantAmount; i++)
-                {
-                    if (strcmp(words[1], tenantNames[i]) == 0)
-                    {
-                        valid = 1;
-                        break;
-                    }
-                }
-                if (valid == 0)
-                {
-                    printf("Input Module Error: invalid tenant\n");
-                    invalid = 1;
-                    continue;
-                }
-                // device name check
-                int deviceValid = 1;
-                int j, k;
-                for (i = deviceIndex; i < wordCount; i++)
-                {
-                    valid = 0;
-                    for (j = 0; j < webcamAmount; j++)
-                    {
-                        if (strcmp(words[i], webcamNames[j]) == 0)
-                        {
-                            valid = 1;
-                            break;
-                        }
-                    }
-                    for (j = 0; j < monitorAmount; j++)
-                    {
-                        if (strcmp(words[i], monitorNames[j]) == 0)
-                        {
-                            valid = 1;
-                            break;
-                        }
-                    }
-                    for (j = 0; j < projectorAmount; j++)
-                    {
-                        if (strcmp(words[i], projectorNames[j]) == 0)
-                        {
-                            valid = 1;
-                            break;
-                        }
-                    }
-                    for (j = 0; j < screenAmount; j++)
-                    {
-                        if (strcmp(words[i], screenNames[j]) == 0)
-                        {
-                            valid = 1;
-                            break;
-                        }
-                    }
-                    if (valid == 0)
-                    {
-                        deviceValid = 0;
-                    }
-                }
-                if (deviceValid == 0)
-                {
-                    printf("Input Module Error: invalid device\n");
-                    invalid = 1;
-                    continue;
-                }
-            }
+// hh:mm to minutes after midnight, return 0 if invalid
+int parseTime(const char *str, int *minutes)
+{
+    if (strlen(str) != 5 || str[2] != ':')
+    {
+        return 0;
+    }
+    int hour = readDigits(str, 2);
+    int minute = readDigits(str + 3, 2);
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59)
+    {
+        return 0;
+    }
+    *minutes = hour * 60 + minute;
+    return 1;
+}
 
-            // handle addBatch command
-            if (strcmp(words[0], "addBatch") == 0)
-            {
-                words[1]++;
-                infilep = fopen(words[1], "r");
-                if (infilep == NULL)
-                {
-                    printf("Input Module: error openning file\n");
-                    invalid = 1;
-                }
-                else
-                {
-                    startBatch = 1;
-                }
-                continue;
-            }
+// n.n hours to minutes, at most one day, return 0 if invalid
+int parseDuration(const char *str, int *minutes)
+{
+    int hours = 0, tenths = 0, digits = 0;
+    while (*str >= '0' && *str <= '9' && digits < 2)
+    {
+        hours = hours * 10 + *str++ - '0';
+        digits++;
+    }
+    if (digits == 0)
+    {
+        return 0;
+    }
+    if (*str == '.')
+    {
+        str++;
+        if ((tenths = readDigits(str, 1)) < 0)
+        {
+            return 0;
+        }
+        str++;
+    }
+    *minutes = hours * 60 + tenths * 6;
+    return *str == 0 && *minutes > 0 && *minutes <= DAY_HOURS * 60;
+}
 
-            free(words);
+// positive number of at most 4 digits, return 0 if invalid
+int parseCount(const char *str, int *count)
+{
+    int length = strlen(str);
+    if (length < 1 || length > 4 || (*count = readDigits(str, length)) <= 0)
+    {
+        return 0;
+    }
+    return 1;
+}
 
-            // Transfer to parent using pipe
-            if (invalid == 0)
-            {
-                write(inputPipe[1][1], buf, COMMAND_CHAR_SIZE);
-            }
+resource_type resourceType(int resource)
+{
+    if (resource < webcamResourceStart)
+    {
+        return roomResource;
+    }
+    if (resource < monitorResourceStart)
+    {
+        return webcamResource;
+    }
+    if (resource < projectorResourceStart)
+    {
+        return monitorResource;
+    }
+    if (resource < screenResourceStart)
+    {
+        return projectorResource;
+    }
+    return screenResource;
+}
 
-            // Determine whether to end program
-            //printf("Input Module: Input line [%s] written to pipe\n", buf);
-            if (strcmp(buf, "endProgram;") == 0)
-            {
-                // printf("Input Module: end program command is received.\n");
-                break;
-            }
-        }
+const char *resourceName(int resource)
+{
+    return catalog.resourceNames[resource];
+}
 
-        // clean up
-        close(inputPipe[1][1]);
-        close(inputPipe[0][0]);
-        // printf("Input Moudle: I have completed!.\n");
-    }
-    else
+// FNV-1a hash of a name
+unsigned int hashName(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    while (*name)
     {
-        // parent process
-        close(inputPipe[1][1]);
-        close(inputPipe[0][0]);
+        hash = (hash ^ (unsigned char)*name++) * 16777619u;
+    }
+    return hash;
+}
 
-        // STEP 2: fork/pipe SCHEDULING MODULE
-        int schedulePipe[2][2];
-        pid_t scheduleCid;
-        // create pipe, parent use [0][1] write, child use [1][1] write
-        for (i = 0; i < 2; i++)
+// id of the name of that kind, -1 if not found
+int lookupName(const char *name, int kind)
+{
+    unsigned int hash = hashName(name);
+    unsigned int slot = hash & nameTableMask;
+    while (nameTable[slot].name != NULL)
+    {
+        if (nameTable[slot].hash == hash && nameTable[slot].kind == kind && strcmp(nameTable[slot].name, name) == 0)
         {
-            if (pipe(schedulePipe[i]) < 0)
-            {
-                printf("Error: input pipe creation error\n");
-                exit(1);
-            }
+            return nameTable[slot].id;
         }
-        if ((scheduleCid = fork()) < 0)
+        slot = (slot + 1) & nameTableMask;
+    }
+    return -1;
+}
+
+// add the name if it is not in the table yet, return its id
+int insertName(const char *name, int kind, int id)
+{
+    unsigned int hash = hashName(name);
+    unsigned int slot = hash & nameTableMask;
+    while (nameTable[slot].name != NULL)
+    {
+        if (nameTable[slot].hash == hash && nameTable[slot].kind == kind && strcmp(nameTable[slot].name, name) == 0)
         {
-            printf("Error: fork scheduling module error\n");
-            exit(1);
+            return nameTable[slot].id;
         }
-        else if (scheduleCid == 0)
-        {
-            // TODO: Scheduling module (Part 2)
-            // -- USEFUL DATA --
-            // storing all the command
-            // note: command can be split using splitCommand()
-            char commandHistory[MAX_COMMAND][COMMAND_CHAR_SIZE];
-            // storing the number of command
-            int numOfCommand = 0;
-            // storing the mode of scheduling
-            char mode[10];
-
-            // closed unused pipes
-            close(inputPipe[0][1]);
-            close(inputPipe[1][1]);
-            close(schedulePipe[1][0]);
-            close(schedulePipe[0][1]);
-            // printf("Schedule Module: Created.\n");
-            // waiting to receive command history from parent
-            int n;
-            int isFirstLine = 1;
-            char buf[COMMAND_CHAR_SIZE];
-            while (1)
-            {
-                n = read(schedulePipe[0][0], buf, COMMAND_CHAR_SIZE);
-                buf[n] = 0;
-                //printf("Scheduling module: received [%s]\n", buf);
-                // whole program is finish, end child
-                if (strcmp(buf, "CLOSE") == 0)
-                {
-                    // printf("Scheduling module: closing...\n");
-                    break;
-                }
-                if (isFirstLine == 1)
-                {
-                    strcpy(mode, buf);
-                    //printf("mode: %s\n", mode);
-                    isFirstLine = 0;
-                }
-                else
-                {
-                    strcpy(commandHistory[numOfCommand], buf);
-                    numOfCommand++;
-                }
-                if (strcmp(buf, "END") == 0)
-                {
-                    char fcfsSchedule[SCHEDULE_STRING_LENGTH + 1];
-                    char prioritySchedule[SCHEDULE_STRING_LENGTH + 1];
-                    int fcfsRejectedCount = 0;
-                    int fcfsRejectedCommandIndex[MAX_COMMAND];
-                    int priorityRejectedCount = 0;
-                    int priorityRejectedCommandIndex[MAX_COMMAND];
-                    //mark the priority level, higher value higher level
-                    int prioritySchedule_p[SCHEDULE_STRING_LENGTH + 1] = {[0 ... SCHEDULE_STRING_LENGTH] = 0};
-                    //mark the index of command, default = -1
-                    int prioritySchedule_c[SCHEDULE_STRING_LENGTH + 1] = {[0 ... SCHEDULE_STRING_LENGTH] = -1};
-
-                    // All data is received from parent
-                    // -- Test Data(Can be deleted) --
-                    /*
-                    for (i = 0; i < 7; i++)
-                    {
-                        char *tempDay = getStringFromInt(i);
-                        strcat(fcfsSchedule, "2021-05-1");
-                        strcat(prioritySchedule, "2021-05-1");
-                        strcat(fcfsSchedule, tempDay);
-                        strcat(prioritySchedule, tempDay);
-                        int limit = (roomAmount + webcamAmount + monitorAmount + projectorAmount + screenAmount) * 24;
-                        int j;
-                        for (j = 0; j < limit; j++)
-                        {
-                            if (i == 4)
-                            {
-                                strcat(fcfsSchedule, "0");
-                                strcat(prioritySchedule, "1");
-                            }
-                            else if (i == 6)
-                            {
-                                strcat(fcfsSchedule, "0");
-                                strcat(prioritySchedule, "0");
-                            }
-                            else
-                            {
-                                strcat(fcfsSchedule, "_");
-                                strcat(prioritySchedule, "_");
-                            }
-                        }
-                        free(tempDay);
-                    }
-                    fcfsRejectedCount = 1;
-                    fcfsRejectedCommandIndex[0] = 3;
-                    priorityRejectedCount = 1;
-                    priorityRejectedCommandIndex[0] = 2;
-                    */
-
-                    //  -- Write it here
-
-                    // main objectives:
-                    // 1. make the schedule by reading the commmad(need commadHistory, numOfCommad)
-                    // 2. put the schedule in the fcfsSchedule / prioritySchedule
-                    // if mode = -fcfs, put the fcfs schedule to fcfsSchedule var
-                    // if mode = -priority, put the priority schedule to prioritySchedule var
-                    // if mode = -ALL, put fcfs schedule to fcfsSchedule var, and priority to prioritySchedule var
-                    // 3. mark the amount of rejected command to [fcfs/priority]RejectedCount
-                    // 4. mark all rejected command index in [fcfs/priority]RejectedCommandIndex
-
-                    // use schedulePipe[1][1] to WRITE TO PARENT
-                    // use schedulePipe[0][0] to READ FROM PARENT
-
-                    typedef struct sub_item
-                    {
-                        int offset;
-                        int length;
-                    } sub_item;
-
-                    typedef enum
-                    {
-                        none,
-                        bookDevice,
-                        addMeeting,
-                        addPresentation,
-                        addConference,
-                    } event_priority;
-
-                    int timeSlotSize = 24;
-                    int date_Length = 10;
-                    sub_item I_room = {date_Length, timeSlotSize};                                                   //3, A,B,C = roomCapacity
-                    sub_item I_webcam = {I_room.offset + (I_room.length * roomAmount), timeSlotSize};                //3 FHD,FHD,UHD
-                    sub_item I_monitor = {I_webcam.offset + (I_webcam.length * webcamAmount), timeSlotSize};         //3 50,50,75
-                    sub_item I_projector = {I_monitor.offset + (I_monitor.length * monitorAmount), timeSlotSize};    //3 2K,2K,4K
-                    sub_item I_screen = {I_projector.offset + (I_projector.length * projectorAmount), timeSlotSize}; //3 100,100,150
-                    int day_Length = I_screen.offset + (I_screen.length * screenAmount);
-
-                    //initialize
-                    if ((sizeof(fcfsSchedule) / sizeof(const char *)) > 1)
-                    {
-                        memset(fcfsSchedule, 0, (SCHEDULE_STRING_LENGTH + 1) * (sizeof(fcfsSchedule[0])));
-                        memset(prioritySchedule, 0, (SCHEDULE_STRING_LENGTH + 1) * (sizeof(prioritySchedule[0])));
-                        memset(fcfsRejectedCommandIndex, 0, (MAX_COMMAND + 1) * (sizeof(fcfsRejectedCommandIndex[0])));
-                        memset(priorityRejectedCommandIndex, 0, (MAX_COMMAND + 1) * (sizeof(priorityRejectedCommandIndex[0])));
-                    }
-                    for (i = 0; i < 7; i++)
-                    {
-                        char *tempDay = getStringFromInt(i);
-                        strcat(fcfsSchedule, "2021-05-1");
-                        strcat(prioritySchedule, "2021-05-1");
-                        strcat(fcfsSchedule, tempDay);
-                        strcat(prioritySchedule, tempDay);
-                        int limit = (roomAmount + webcamAmount + monitorAmount + projectorAmount + screenAmount) * 24;
-                        int j;
-                        for (j = 0; j < limit; j++)
-                        {
-                            strcat(fcfsSchedule, "_");
-                            strcat(prioritySchedule, "_");
-                        }
-                        free(tempDay);
-                    }
-
-                    int S_numOfWords;
-                    char **S_words;
-                    int S_CommandIndex; //for looping use
-                    event_priority eventType;
-                    //bbbbbbbb
-                    for (S_CommandIndex = 0; S_CommandIndex < numOfCommand; S_CommandIndex++)
-                    { //for each command
-                        // identify command
-                        eventType = none;
-
-                        //seperate command to word
-                        S_numOfWords = getNumOfWord(commandHistory[S_CommandIndex], strlen(commandHistory[S_CommandIndex]));
-                        S_words = splitCommand(commandHistory[S_CommandIndex], strlen(commandHistory[S_CommandIndex]));
-
-                        printf("%d: %s\n", S_CommandIndex + 1, S_words[0]);
-                        if (strcmp(S_words[0], "END") == 0)
-                        {
-                            break;
-                        }
-
-                        if (strcmp(S_words[0], "addMeeting") == 0)
-                        { //prio = 2
-                            eventType = addMeeting;
-                        }
-                        else if (strcmp(S_words[0], "addPresentation") == 0)
-                        { //prio = 3
-                            eventType = addPresentation;
-                        }
-                        else if (strcmp(S_words[0], "addConference") == 0)
-                        { //prio = 4
-                            eventType = addConference;
-                        }
-                        else if (strcmp(S_words[0], "bookDevice") == 0)
-                        { //prio = 1
-                            eventType = bookDevice;
-                        }
-                        else
-                        {
-                            //printf("invalid input at Scheduling module\n");
-                            continue;
-                        }
-
-                        char tempStr[WORD_CHAR_LIMIT];
-                        int cur_day_offset = charToInt(S_words[2][9]) * day_Length; //YYYY-MM-D[D]
-                        strncpy(tempStr, S_words[3], 2);                            //[hh]:mm
-                        int cur_time = getIntFromString(tempStr);                   //[hh]:mm
-                        int cur_dur = charToInt(S_words[4][0]);                     //[n].n
-
-                        int fcfs_rej_flag = 0;
-                        int prio_rej_flag = 0;
+        slot = (slot + 1) & nameTableMask;
+    }
+    nameTable[slot] = (nameEntry){name, hash, kind, id};
+    return id;
+}
 
-                        // check room part
-                        int fcfsSelectedRoom = -1;
-                        int prioSelectedRoom = -1;
+// build the table from the tenant and device names of the catalog
+// units with the same name share one device model, kept in resourceModel
+// return NULL if built, otherwise the error message
+const char *nameTableInit(void)
+{
+    int i, resource;
+    unsigned int size = 1;
+    while (size < 2 * (unsigned int)(tenantAmount + resourceAmount))
+    {
+        size *= 2;
+    }
+    nameTable = calloc(size, sizeof(nameEntry));
+    resourceModel = calloc(resourceAmount + 1, sizeof(int));
+    if (nameTable == NULL || resourceModel == NULL)
+    {
+        return "name table creation error";
+    }
+    nameTableMask = size - 1;
+    for (i = 0; i < tenantAmount; i++)
+    {
+        if (insertName(catalog.tenantNames[i], tenantName, i) != i)
+        {
+            return "a tenant is listed twice in the catalog";
+        }
+    }
+    for (resource = webcamResourceStart; resource < resourceAmount; resource++)
+    {
+        resourceModel[resource] = insertName(resourceName(resource), deviceName, resource);
+        // the model is the first unit of the name, so a model never spans two resource types
+        if (resourceType(resourceModel[resource]) != resourceType(resource))
+        {
+            return "a device name is used by two kinds in the catalog";
+        }
+    }
+    return NULL;
+}
 
-                        if ((eventType != none) && (eventType != bookDevice))
-                        { //plan room, if addMeeting addPresentation addConference
+// index in the tenants of the catalog, -1 if not found
+int findTenant(const char *name)
+{
+    return lookupName(name, tenantName);
+}
 
-                            int cur_person = getIntFromString(S_words[5]); //[p]
-                            int cur_roomSuitable[roomAmount] = {[0 ... roomAmount - 1] = 1};
-                            int cur_roomSuitableCount = 0;
+// device model of the name, -1 if not found
+int findDevice(const char *name)
+{
+    return lookupName(name, deviceName);
+}
 
-                            for (i = 0; i < roomAmount; i++)
-                            {
-                                if (cur_person > roomCapacity[i])
-                                {
-                                    cur_roomSuitable[i] = 0;
-                                }
-                                else
-                                {
-                                    cur_roomSuitableCount++;
-                                }
-                            }
-                            if (cur_roomSuitableCount == 0)
-                            {
-                                fcfs_rej_flag = 1;
-                                prio_rej_flag = 1;
-                            }
+// parse the words of a booking command
+// return NULL if valid, otherwise the error message
+const char *parseBooking(char **words, int wordCount, booking *b)
+{
+    int i, deviceIndex, value;
+    memset(b, 0, sizeof(*b));
+    for (i = bookDevice; i <= addConference; i++)
+    {
+        if (strcmp(words[0], eventNames[i]) == 0)
+        {
+            break;
+        }
+    }
+    if (i > addConference)
+    {
+        return "unknown command";
+    }
+    b->type = i;
+    deviceIndex = b->type == bookDevice ? 5 : 6;
+    if (wordCount < deviceIndex)
+    {
+        return b->type == bookDevice ? "must have at least 5 words" : "must have at least 6 words";
+    }
+    if (wordCount > deviceIndex + MAX_BOOKING_DEVICE)
+    {
+        return "too many devices";
+    }
+    if (words[1][0] != '-' || (value = findTenant(words[1] + 1)) < 0)
+    {
+        return "invalid tenant";
+    }
+    b->tenant = value;
+    if (!parseDate(words[2], &b->day))
+    {
+        return "invalid date, must be YYYY-MM-DD";
+    }
+    if (!parseTime(words[3], &value))
+    {
+        return "invalid time, must be hh:mm";
+    }
+    b->startMinute = value;
+    if (!parseDuration(words[4], &value))
+    {
+        return "invalid duration, must be n.n hours";
+    }
+    b->duration = value;
+    if (b->type != bookDevice)
+    {
+        if (!parseCount(words[5], &value))
+        {
+            return "invalid number of participants";
+        }
+        b->participants = value;
+    }
+    for (i = deviceIndex; i < wordCount; i++)
+    {
+        if ((value = findDevice(words[i])) < 0)
+        {
+            return "invalid device";
+        }
+        b->device[b->deviceCount++] = value;
+    }
+    if (b->type == bookDevice && b->deviceCount != 1)
+    {
+        return "bookDevice needs one device";
+    }
+    return NULL;
+}
 
-                            int fcfsSectionNotAvailableFlag[roomAmount] = {[0 ... roomAmount - 1] = 0};
-                            int prioSectionNotAvailableFlag[roomAmount] = {[0 ... roomAmount - 1] = 0};
-                            int prioSectionNotdisplaceableFlag[roomAmount] = {[0 ... roomAmount - 1] = 0};
-                            int prioSectiondisplaceablePrio[roomAmount] = {[0 ... roomAmount - 1] = 0};
-                            for (i = 0; i < roomAmount; i++)
-                            { //loop all room
-                                int j;
-                                if (cur_roomSuitable[i] == 1)
-                                { // only check the room with suitable size
-                                    fcfsSectionNotAvailableFlag[i] = 0;
-                                    prioSectionNotAvailableFlag[i] = 0;
-                                    prioSectionNotdisplaceableFlag[i] = 0;
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        //check room available
-                                        int checkSlot = cur_day_offset + I_room.offset + (I_room.length * i) + cur_time + j;
-                                        if (fcfsSchedule[checkSlot] != '_')
-                                        {
-                                            fcfsSectionNotAvailableFlag[i] = 1;
-                                        }
-                                        if (prioritySchedule_p[checkSlot] > 0)
-                                        {
-                                            prioSectionNotAvailableFlag[i] = 1;
-                                        }
-                                        if (prioritySchedule_p[checkSlot] >= eventType)
-                                        { //check prio
-                                            prioSectionNotdisplaceableFlag[i] = 1;
-                                        }
-                                        else
-                                        {
-                                            prioSectiondisplaceablePrio[i] = prioritySchedule_p[checkSlot];
-                                        }
-                                    }
-                                }
-                            }
-                            for (i = 0; i < roomAmount; i++)
-                            { //loop all room for fcfs choose room
-                                if ((!fcfsSectionNotAvailableFlag[i]) && (cur_roomSuitable[i] == 1))
-                                {
-                                    fcfsSelectedRoom = i;
-                                    break;
-                                }
-                            }
-                            for (i = 0; i < roomAmount; i++)
-                            { //loop all room for prio choose room
-                                if ((!prioSectionNotAvailableFlag[i]) && (cur_roomSuitable[i] == 1))
-                                {
-                                    prioSelectedRoom = i;
-                                    break;
-                                }
-                            }
-                            if (prioSelectedRoom < 0)
-                            {
-                                int minPrio = 255;
-                                int min = 255;
-                                for (i = 0; i < roomAmount; i++)
-                                { //loop all room for prio displace room
-                                    if ((!prioSectionNotdisplaceableFlag[i]) && (cur_roomSuitable[i] == 1))
-                                    {
-                                        if (minPrio > prioSectiondisplaceablePrio[i])
-                                        {
-                                            minPrio = prioSectiondisplaceablePrio[i];
-                                            min = i;
-                                        }
-                                        //prioSelectedRoom = i;
-                                        //break;
-                                    }
-                                }
-                                if (min < 255)
-                                {
-                                    prioSelectedRoom = min;
-                                }
-                            }
-                            if (fcfsSelectedRoom < 0)
-                            {
-                                fcfs_rej_flag = 1;
-                            }
-                            if (prioSelectedRoom < 0)
-                            {
-                                prio_rej_flag = 1;
-                            }
-                        }
+// 1 for each booking a later command cancels, kept by the input module so a booking is cancelled once
+// a move can fail on a schedule, so it does not end the booking
+char *bookingChanged = NULL;
 
-                        int devicePair = 0; //0 = none, 1 = [projector]+[screen], 2 = [webcam]+[monitor]
-                        // check device part pair 1
-                        int fcfsSelectedProjector = -1;
-                        int prioSelectedProjector = -1;
-                        int fcfsSelectedScreen = -1;
-                        int prioSelectedScreen = -1;
-                        // check device part pair 2
-                        int fcfsSelectedWebcam = -1;
-                        int prioSelectedWebcam = -1;
-                        int fcfsSelectedMonitor = -1;
-                        int prioSelectedMonitor = -1;
-                        if ((S_numOfWords >= 7) || (eventType == bookDevice))
-                        { //plan device, if has device booking
-
-                            char RequestPType[WORD_CHAR_LIMIT];
-                            char RequestSType[WORD_CHAR_LIMIT];
-                            char RequestWType[WORD_CHAR_LIMIT];
-                            char RequestMType[WORD_CHAR_LIMIT];
-
-                            if (eventType != bookDevice)
-                            {
-                                if (((S_words[6][0] == 'p') && (S_words[7][0] == 's')) || ((S_words[6][0] == 's') && (S_words[7][0] == 'p')))
-                                { //[projector]+[screen]
-                                    devicePair = 1;
-                                    if (S_words[6][0] == 'p')
-                                    {
-                                        strcpy(RequestPType, S_words[6]);
-                                        strcpy(RequestSType, S_words[7]);
-                                    }
-                                    else
-                                    {
-                                        strcpy(RequestPType, S_words[7]);
-                                        strcpy(RequestSType, S_words[6]);
-                                    }
-                                }
-                                else if (((S_words[6][0] == 'w') && (S_words[7][0] == 'm')) || ((S_words[6][0] == 'm') && (S_words[7][0] == 'w')))
-                                { //[webcam]+[monitor]
-                                    devicePair = 2;
-                                    if (S_words[6][0] == 'w')
-                                    {
-                                        strcpy(RequestWType, S_words[6]);
-                                        strcpy(RequestMType, S_words[7]);
-                                    }
-                                    else
-                                    {
-                                        strcpy(RequestWType, S_words[7]);
-                                        strcpy(RequestMType, S_words[6]);
-                                    }
-                                }
-                                else
-                                {
-                                    printf("invalid input at Scheduling module(device not in pair)\n");
-                                    break;
-                                }
-                            }
-                            else
-                            { //eventType == bookDevice
-                                switch (S_words[5][0])
-                                {
-                                case 'p':
-                                    strcpy(RequestPType, S_words[5]);
-                                    break;
-                                case 's':
-                                    strcpy(RequestSType, S_words[5]);
-                                    break;
-                                case 'w':
-                                    strcpy(RequestWType, S_words[5]);
-                                    break;
-                                case 'm':
-                                    strcpy(RequestMType, S_words[5]);
-                                    break;
-                                default:
-                                    printf("no such device\n");
-                                    break;
-                                }
-                            }
+// -<booking number> to the id of a booking before id, return 0 if invalid
+int parseBookingId(const char *str, int id, int *target)
+{
+    int length = strlen(str), value;
+    if (str[0] != '-' || length < 2 || length > 9 || (value = readDigits(str + 1, length - 1)) < 1 || value > id)
+    {
+        return 0;
+    }
+    *target = value - 1;
+    return 1;
+}
 
-                            if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 'p')))
-                            { // projector
-                                //check if request device correct
-                                int cur_pSuitable[projectorAmount] = {[0 ... projectorAmount - 1] = 1};
-                                int cur_pSuitableCount = 0;
+// id of the first command of the booking the entry is a version of
+// the change entries of older logs hold the id as it was typed, so the moves are followed back
+int bookingRoot(const booking *bookings, int id)
+{
+    while (bookings[id].target != 0)
+    {
+        id = bookings[id].target - 1;
+    }
+    return id;
+}
 
-                                for (i = 0; i < projectorAmount; i++)
-                                {
-                                    if (strcmp(RequestPType, projectorNames[i]) != 0)
-                                    {
-                                        cur_pSuitable[i] = 0;
-                                    }
-                                    else
-                                    {
-                                        cur_pSuitableCount++;
-                                    }
-                                }
-                                if (cur_pSuitableCount == 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                    prio_rej_flag = 1;
-                                }
+// parse cancelBooking -<booking> or moveBooking -<booking> YYYY-MM-DD hh:mm n.n into the store at id
+// return NULL if valid, otherwise the error message
+const char *parseChange(char **words, int wordCount, booking *bookings, int id)
+{
+    booking *b = &bookings[id];
+    int isMove = strcmp(words[0], "moveBooking") == 0, target, root, value;
+    if (wordCount != (isMove ? 5 : 2))
+    {
+        return isMove ? "must have 5 words" : "must have 2 words";
+    }
+    if (!parseBookingId(words[1], id, &target) || bookings[target].type == cancelBooking)
+    {
+        return "invalid booking number";
+    }
+    root = bookingRoot(bookings, target);
+    if (bookingChanged[root])
+    {
+        return "the booking is already cancelled";
+    }
+    *b = bookings[target];
+    b->target = root + 1;
+    if (!isMove)
+    {
+        b->type = cancelBooking;
+    }
+    else if (!parseDate(words[2], &b->day))
+    {
+        return "invalid date, must be YYYY-MM-DD";
+    }
+    else if (!parseTime(words[3], &value))
+    {
+        return "invalid time, must be hh:mm";
+    }
+    else
+    {
+        b->startMinute = value;
+        if (!parseDuration(words[4], &value))
+        {
+            return "invalid duration, must be n.n hours";
+        }
+        b->duration = value;
+    }
+    if (!isMove)
+    {
+        bookingChanged[root] = 1;
+    }
+    return NULL;
+}
 
-                                //check if projector available
-                                int fcfsSectionNotAvailableFlag_p[projectorAmount] = {[0 ... projectorAmount - 1] = 0};
-                                int prioSectionNotAvailableFlag_p[projectorAmount] = {[0 ... projectorAmount - 1] = 0};
-                                int prioSectionNotdisplaceableFlag_p[projectorAmount] = {[0 ... projectorAmount - 1] = 0};
-                                int prioSectiondisplaceablePrio_p[projectorAmount] = {[0 ... projectorAmount - 1] = 0};
-                                for (i = 0; i < projectorAmount; i++)
-                                { //loop all projector
-                                    int j;
-                                    if (cur_pSuitable[i] == 1)
-                                    { // only check the projector with suitable size
-                                        fcfsSectionNotAvailableFlag_p[i] = 0;
-                                        prioSectionNotAvailableFlag_p[i] = 0;
-                                        prioSectionNotdisplaceableFlag_p[i] = 0;
-                                        for (j = 0; j < cur_dur; j++)
-                                        {
-                                            //check projector available
-                                            int checkSlot = cur_day_offset + I_projector.offset + (I_projector.length * i) + cur_time + j;
-                                            if (fcfsSchedule[checkSlot] != '_')
-                                            {
-                                                fcfsSectionNotAvailableFlag_p[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] > 0)
-                                            {
-                                                prioSectionNotAvailableFlag_p[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] >= eventType)
-                                            { //check prio
-                                                prioSectionNotdisplaceableFlag_p[i] = 1;
-                                            }
-                                            else
-                                            {
-                                                prioSectiondisplaceablePrio_p[i] = prioritySchedule_p[checkSlot];
-                                            }
-                                        }
-                                    }
-                                }
-                                for (i = 0; i < projectorAmount; i++)
-                                { //loop all projector for fcfs choose projector
-                                    if ((!fcfsSectionNotAvailableFlag_p[i]) && (cur_pSuitable[i] == 1))
-                                    {
-                                        fcfsSelectedProjector = i;
-                                        break;
-                                    }
-                                }
-                                for (i = 0; i < projectorAmount; i++)
-                                { //loop all projector for prio choose projector
-                                    if ((!prioSectionNotAvailableFlag_p[i]) && (cur_pSuitable[i] == 1))
-                                    {
-                                        prioSelectedProjector = i;
-                                        break;
-                                    }
-                                }
-                                if (prioSelectedProjector < 0)
-                                {
-                                    int minPrio = 255;
-                                    int min = 255;
-                                    for (i = 0; i < projectorAmount; i++)
-                                    { //loop all projector for prio displace projector
-                                        if ((!prioSectionNotdisplaceableFlag_p[i]) && (cur_pSuitable[i] == 1))
-                                        {
-                                            if (minPrio > prioSectiondisplaceablePrio_p[i])
-                                            {
-                                                minPrio = prioSectiondisplaceablePrio_p[i];
-                                                min = i;
-                                            }
-                                        }
-                                    }
-                                    if (min < 255)
-                                    {
-                                        prioSelectedProjector = min;
-                                    }
-                                }
-                                if (fcfsSelectedProjector < 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                }
-                                if (prioSelectedProjector < 0)
-                                {
-                                    prio_rej_flag = 1;
-                                }
-                            }
+// parse a booking, cancelBooking or moveBooking command into the store at id
+// return NULL if valid, otherwise the error message
+const char *parseEntry(char **words, int wordCount, booking *bookings, int id)
+{
+    if (strcmp(words[0], "cancelBooking") == 0 || strcmp(words[0], "moveBooking") == 0)
+    {
+        return parseChange(words, wordCount, bookings, id);
+    }
+    return parseBooking(words, wordCount, &bookings[id]);
+}
 
-                            if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 's')))
-                            { // screen
-                                //check if request device correct
-                                int cur_sSuitable[screenAmount] = {[0 ... screenAmount - 1] = 1};
-                                int cur_sSuitableCount = 0;
+// name of the command of a store entry
+const char *commandName(const booking *b)
+{
+    return b->target != 0 && b->type != cancelBooking ? "moveBooking" : eventNames[b->type];
+}
 
-                                for (i = 0; i < screenAmount; i++)
-                                {
-                                    if (strcmp(RequestSType, screenNames[i]) != 0)
-                                    {
-                                        cur_sSuitable[i] = 0;
-                                    }
-                                    else
-                                    {
-                                        cur_sSuitableCount++;
-                                    }
-                                }
-                                if (cur_sSuitableCount == 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                    prio_rej_flag = 1;
-                                }
+// the booking in hour slots of the calendar, partly used hours are included
+int bookingStartHour(const booking *b)
+{
+    return b->startMinute / 60;
+}
 
-                                //check if screen available
-                                int fcfsSectionNotAvailableFlag_s[screenAmount] = {[0 ... screenAmount - 1] = 0};
-                                int prioSectionNotAvailableFlag_s[screenAmount] = {[0 ... screenAmount - 1] = 0};
-                                int prioSectionNotdisplaceableFlag_s[screenAmount] = {[0 ... screenAmount - 1] = 0};
-                                int prioSectiondisplaceablePrio_s[screenAmount] = {[0 ... screenAmount - 1] = 0};
-                                for (i = 0; i < screenAmount; i++)
-                                { //loop all screen
-                                    int j;
-                                    if (cur_sSuitable[i] == 1)
-                                    { // only check the screen with suitable size
-                                        fcfsSectionNotAvailableFlag_s[i] = 0;
-                                        prioSectionNotAvailableFlag_s[i] = 0;
-                                        prioSectionNotdisplaceableFlag_s[i] = 0;
-                                        for (j = 0; j < cur_dur; j++)
-                                        {
-                                            //check screen available
-                                            int checkSlot = cur_day_offset + I_screen.offset + (I_screen.length * i) + cur_time + j;
-                                            if (fcfsSchedule[checkSlot] != '_')
-                                            {
-                                                fcfsSectionNotAvailableFlag_s[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] > 0)
-                                            {
-                                                prioSectionNotAvailableFlag_s[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] >= eventType)
-                                            { //check prio
-                                                prioSectionNotdisplaceableFlag_s[i] = 1;
-                                            }
-                                            else
-                                            {
-                                                prioSectiondisplaceablePrio_s[i] = prioritySchedule_p[checkSlot];
-                                            }
-                                        }
-                                    }
-                                }
-                                for (i = 0; i < screenAmount; i++)
-                                { //loop all screen for fcfs choose screen
-                                    if ((!fcfsSectionNotAvailableFlag_s[i]) && (cur_sSuitable[i] == 1))
-                                    {
-                                        fcfsSelectedScreen = i;
-                                        break;
-                                    }
-                                }
-                                for (i = 0; i < screenAmount; i++)
-                                { //loop all screen for prio choose screen
-                                    if ((!prioSectionNotAvailableFlag_s[i]) && (cur_sSuitable[i] == 1))
-                                    {
-                                        prioSelectedScreen = i;
-                                        break;
-                                    }
-                                }
-                                if (prioSelectedScreen < 0)
-                                {
-                                    int minPrio = 255;
-                                    int min = 255;
-                                    for (i = 0; i < screenAmount; i++)
-                                    { //loop all screen for prio displace screen
-                                        if ((!prioSectionNotdisplaceableFlag_s[i]) && (cur_sSuitable[i] == 1))
-                                        {
-                                            if (minPrio > prioSectiondisplaceablePrio_s[i])
-                                            {
-                                                minPrio = prioSectiondisplaceablePrio_s[i];
-                                                min = i;
-                                            }
-                                        }
-                                    }
-                                    if (min < 255)
-                                    {
-                                        prioSelectedScreen = min;
-                                    }
-                                }
-                                if (fcfsSelectedScreen < 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                }
-                                if (prioSelectedScreen < 0)
-                                {
-                                    prio_rej_flag = 1;
-                                }
-                            }
+int bookingHours(const booking *b)
+{
+    return (b->startMinute + b->duration + 59) / 60 - b->startMinute / 60;
+}
 
-                            if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'w')))
-                            { // webcam
-                                //check if request device correct
-                                int cur_wSuitable[webcamAmount] = {[0 ... webcamAmount - 1] = 1};
-                                int cur_wSuitableCount = 0;
+// record an accepted booking, units is the calendar index of the unit given of each resource_type
+void assignBooking(assignment *a, const booking *b, const int *units)
+{
+    int n;
+    a->room = units[roomResource] < 0 ? -1 : units[roomResource] - roomResourceStart;
+    for (n = 0; n < MAX_BOOKING_DEVICE; n++)
+    {
+        a->device[n] = n < b->deviceCount ? units[resourceType(b->device[n])] : -1;
+    }
+    a->accepted = 1;
+    a->evictedBy = -1;
+}
 
-                                for (i = 0; i < webcamAmount; i++)
-                                {
-                                    if (strcmp(RequestWType, webcamNames[i]) != 0)
-                                    {
-                                        cur_wSuitable[i] = 0;
-                                    }
-                                    else
-                                    {
-                                        cur_wSuitableCount++;
-                                    }
-                                }
-                                if (cur_wSuitableCount == 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                    prio_rej_flag = 1;
-                                }
+//  -- Catalog loading --
+// the parent loads the catalog once, the names point into its text for the whole program
 
-                                //check if webcam available
-                                int fcfsSectionNotAvailableFlag_w[webcamAmount] = {[0 ... webcamAmount - 1] = 0};
-                                int prioSectionNotAvailableFlag_w[webcamAmount] = {[0 ... webcamAmount - 1] = 0};
-                                int prioSectionNotdisplaceableFlag_w[webcamAmount] = {[0 ... webcamAmount - 1] = 0};
-                                int prioSectiondisplaceablePrio_w[webcamAmount] = {[0 ... webcamAmount - 1] = 0};
-                                for (i = 0; i < webcamAmount; i++)
-                                { //loop all webcam
-                                    int j;
-                                    if (cur_wSuitable[i] == 1)
-                                    { // only check the webcam with suitable size
-                                        fcfsSectionNotAvailableFlag_w[i] = 0;
-                                        prioSectionNotAvailableFlag_w[i] = 0;
-                                        prioSectionNotdisplaceableFlag_w[i] = 0;
-                                        for (j = 0; j < cur_dur; j++)
-                                        {
-                                            //check webcam available
-                                            int checkSlot = cur_day_offset + I_webcam.offset + (I_webcam.length * i) + cur_time + j;
-                                            if (fcfsSchedule[checkSlot] != '_')
-                                            {
-                                                fcfsSectionNotAvailableFlag_w[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] > 0)
-                                            {
-                                                prioSectionNotAvailableFlag_w[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] >= eventType)
-                                            { //check prio
-                                                prioSectionNotdisplaceableFlag_w[i] = 1;
-                                            }
-                                            else
-                                            {
-                                                prioSectiondisplaceablePrio_w[i] = prioritySchedule_p[checkSlot];
-                                            }
-                                        }
-                                    }
-                                }
-                                for (i = 0; i < webcamAmount; i++)
-                                { //loop all webcam for fcfs choose webcam
-                                    if ((!fcfsSectionNotAvailableFlag_w[i]) && (cur_wSuitable[i] == 1))
-                                    {
-                                        fcfsSelectedWebcam = i;
-                                        break;
-                                    }
-                                }
-                                for (i = 0; i < webcamAmount; i++)
-                                { //loop all webcam for prio choose webcam
-                                    if ((!prioSectionNotAvailableFlag_w[i]) && (cur_wSuitable[i] == 1))
-                                    {
-                                        prioSelectedWebcam = i;
-                                        break;
-                                    }
-                                }
-                                if (prioSelectedWebcam < 0)
-                                {
-                                    int minPrio = 255;
-                                    int min = 255;
-                                    for (i = 0; i < webcamAmount; i++)
-                                    { //loop all webcam for prio displace webcam
-                                        if ((!prioSectionNotdisplaceableFlag_w[i]) && (cur_wSuitable[i] == 1))
-                                        {
-                                            if (minPrio > prioSectiondisplaceablePrio_w[i])
-                                            {
-                                                minPrio = prioSectiondisplaceablePrio_w[i];
-                                                min = i;
-                                            }
-                                        }
-                                    }
-                                    if (min < 255)
-                                    {
-                                        prioSelectedWebcam = min;
-                                    }
-                                }
-                                if (fcfsSelectedWebcam < 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                }
-                                if (prioSelectedWebcam < 0)
-                                {
-                                    prio_rej_flag = 1;
-                                }
-                            }
+// read the whole file as a string, NULL if it cannot be read
+char *readCatalogFile(const char *fileName)
+{
+    struct stat fileStat;
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+    {
+        return NULL;
+    }
+    if (fstat(file, &fileStat) < 0)
+    {
+        close(file);
+        return NULL;
+    }
+    char *text = malloc(fileStat.st_size + 1);
+    ssize_t length = text == NULL ? -1 : read(file, text, fileStat.st_size);
+    close(file);
+    if (length < 0)
+    {
+        free(text);
+        return NULL;
+    }
+    text[length] = 0;
+    return text;
+}
 
-                            if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'm')))
-                            { // monitor
-                                //check if request device correct
-                                int cur_mSuitable[monitorAmount] = {[0 ... monitorAmount - 1] = 1};
-                                int cur_mSuitableCount = 0;
+// resource_type of the first word of a catalog line, -1 for a tenant, -2 if unknown
+int catalogKind(const char *word)
+{
+    int t;
+    if (strcmp(word, "tenant") == 0)
+    {
+        return -1;
+    }
+    for (t = roomResource; t <= screenResource; t++)
+    {
+        if (strcmp(word, resourceKindNames[t]) == 0)
+        {
+            return t;
+        }
+    }
+    return -2;
+}
 
-                                for (i = 0; i < monitorAmount; i++)
-                                {
-                                    if (strcmp(RequestMType, monitorNames[i]) != 0)
-                                    {
-                                        cur_mSuitable[i] = 0;
-                                    }
-                                    else
-                                    {
-                                        cur_mSuitableCount++;
-                                    }
-                                }
-                                if (cur_mSuitableCount == 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                    prio_rej_flag = 1;
-                                }
+// parse the catalog text in place, the units of each resource_type are kept in the file order
+// return NULL if valid, otherwise the error message and its line in *errorLine
+const char *catalogLoad(char *text, int *errorLine)
+{
+    int lineAmount = 1, line, i, t;
+    int typeAmount[screenResource + 1] = {0};
+    char *p;
+    for (p = text; *p != 0; p++)
+    {
+        lineAmount += *p == '\n';
+    }
+    // the kind, name and count of each line
+    int *lineKind = malloc(lineAmount * sizeof(int));
+    int *lineValue = malloc(lineAmount * sizeof(int));
+    char **lineName = malloc(lineAmount * sizeof(char *));
+    if (lineKind == NULL || lineValue == NULL || lineName == NULL)
+    {
+        free(lineKind), free(lineValue), free(lineName);
+        *errorLine = 0;
+        return "out of memory";
+    }
+    catalog.text = text;
+    tenantAmount = 0;
+    resourceAmount = 0;
+    const char *error = NULL;
+    for (line = 0, p = text; line < lineAmount && error == NULL; line++)
+    {
+        char *lineEnd = strchr(p, '\n');
+        char *words[4];
+        if (lineEnd != NULL)
+        {
+            *lineEnd = 0;
+        }
+        int wordCount = splitWords(p, words, 4);
+        p = lineEnd != NULL ? lineEnd + 1 : p + strlen(p);
+        *errorLine = line + 1;
+        lineKind[line] = -2;
+        if (wordCount == 0)
+        {
+            continue;
+        }
+        int kind = catalogKind(words[0]);
+        if (kind == -2)
+        {
+            error = "unknown kind, must be tenant, room, webcam, monitor, projector or screen";
+        }
+        else if (wordCount != (kind == -1 ? 2 : 3))
+        {
+            error = kind == -1 ? "a tenant must have 2 words" : "a room or device must have 3 words";
+        }
+        else if (strlen(words[1]) > WORD_CHAR_LIMIT)
+        {
+            error = "name is too long";
+        }
+        else if (kind >= 0 && !parseCount(words[2], &lineValue[line]))
+        {
+            error = kind == roomResource ? "invalid capacity" : "invalid number of units";
+        }
+        else if (kind == -1 && ++tenantAmount > CATALOG_TENANT_LIMIT)
+        {
+            error = "too many tenants";
+        }
+        else if (kind >= 0 && (resourceAmount += kind == roomResource ? 1 : lineValue[line]) > CATALOG_UNIT_LIMIT)
+        {
+            error = "too many rooms and device units";
+        }
+        else
+        {
+            lineKind[line] = kind;
+            lineName[line] = words[1];
+            if (kind >= 0)
+            {
+                typeAmount[kind] += kind == roomResource ? 1 : lineValue[line];
+            }
+        }
+    }
+    if (error == NULL && (tenantAmount == 0 || typeAmount[roomResource] == 0))
+    {
+        *errorLine = 0;
+        error = "must have at least one tenant and one room";
+    }
+    if (error == NULL)
+    {
+        catalog.tenantNames = malloc(tenantAmount * sizeof(char *));
+        catalog.resourceNames = malloc(resourceAmount * sizeof(char *));
+        catalog.roomCapacity = malloc(typeAmount[roomResource] * sizeof(int));
+        if (catalog.tenantNames == NULL || catalog.resourceNames == NULL || catalog.roomCapacity == NULL)
+        {
+            *errorLine = 0;
+            error = "out of memory";
+        }
+    }
+    if (error == NULL)
+    {
+        int filled[screenResource + 1] = {0}, tenants = 0;
+        catalog.typeStart[0] = 0;
+        for (t = 0; t <= screenResource; t++)
+        {
+            catalog.typeStart[t + 1] = catalog.typeStart[t] + typeAmount[t];
+        }
+        for (line = 0; line < lineAmount; line++)
+        {
+            t = lineKind[line];
+            if (t == -1)
+            {
+                catalog.tenantNames[tenants++] = lineName[line];
+            }
+            else if (t == roomResource)
+            {
+                catalog.roomCapacity[filled[t]] = lineValue[line];
+                catalog.resourceNames[catalog.typeStart[t] + filled[t]++] = lineName[line];
+            }
+            for (i = 0; t > roomResource && i < lineValue[line]; i++)
+            {
+                catalog.resourceNames[catalog.typeStart[t] + filled[t]++] = lineName[line];
+            }
+        }
+    }
+    free(lineKind);
+    free(lineValue);
+    free(lineName);
+    return error;
+}
+
+//  -- Calendar functions --
+// the calendar is called with a day, a start hour and a number of hours like the bookings,
+// and turns them into absolute hours
+
+// reserve the calendar, return 0 if it cannot be mapped
+int calendarInit(calendar *c)
+{
+    c->nodes = mmap(NULL, (size_t)CALENDAR_NODE_CAPACITY * sizeof(intervalNode), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (c->nodes == MAP_FAILED)
+    {
+        return 0;
+    }
+    c->root = mmap(NULL, resourceAmount * sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (c->root == MAP_FAILED)
+    {
+        return 0;
+    }
+    c->heldBy = mmap(NULL, (size_t)BOOKING_STORE_CAPACITY * sizeof(int), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (c->heldBy == MAP_FAILED)
+    {
+        return 0;
+    }
+    memset(c->root, 0, resourceAmount * sizeof(int));
+    c->nodeCount = 0;
+    c->freeNode = 0;
+    return 1;
+}
+
+// take every interval of the commands [0, numOfCommand) off the calendar, the nodes are used again from the first one
+void calendarClear(calendar *c, int numOfCommand)
+{
+    memset(c->root, 0, resourceAmount * sizeof(int));
+    memset(c->heldBy, 0, numOfCommand * sizeof(int));
+    c->nodeCount = 0;
+    c->freeNode = 0;
+}
+
+// 1 if the hours [start, end) are inside the calendar
+int calendarHasHours(int start, int end)
+{
+    return start >= CALENDAR_FIRST_DAY * DAY_HOURS && end <= (CALENDAR_FIRST_DAY + CALENDAR_DAYS) * DAY_HOURS;
+}
+
+// heap key of a node, mixed from its index so the treap stays balanced without a random state
+unsigned int treapWeight(int node)
+{
+    unsigned int x = node;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// join two trees, every start in left is before every start in right
+int treapMerge(intervalNode *nodes, int left, int right)
+{
+    if (left == 0 || right == 0)
+    {
+        return left + right;
+    }
+    if (treapWeight(left) > treapWeight(right))
+    {
+        nodes[left].right = treapMerge(nodes, nodes[left].right, right);
+        return left;
+    }
+    nodes[right].left = treapMerge(nodes, left, nodes[right].left);
+    return right;
+}
+
+// cut a tree into the intervals starting before hour, and the others
+void treapSplit(intervalNode *nodes, int tree, int hour, int *left, int *right)
+{
+    if (tree == 0)
+    {
+        *left = *right = 0;
+    }
+    else if (nodes[tree].start < hour)
+    {
+        treapSplit(nodes, nodes[tree].right, hour, &nodes[tree].right, right);
+        *left = tree;
+    }
+    else
+    {
+        treapSplit(nodes, nodes[tree].left, hour, left, &nodes[tree].left);
+        *right = tree;
+    }
+}
+
+// the last interval of the resource starting before hour, 0 if none
+int calendarBefore(const calendar *c, int resource, int hour)
+{
+    int node = c->root[resource];
+    int found = 0;
+    while (node != 0)
+    {
+        if (c->nodes[node].start < hour)
+        {
+            found = node;
+            node = c->nodes[node].right;
+        }
+        else
+        {
+            node = c->nodes[node].left;
+        }
+    }
+    return found;
+}
+
+// the last interval of the resource overlapping [start, end), 0 if none
+// the one before it overlapping is found by searching again before its start
+int calendarOverlap(const calendar *c, int resource, int start, int end)
+{
+    int node = calendarBefore(c, resource, end);
+    return (node != 0 && c->nodes[node].end > start) ? node : 0;
+}
+
+// the first interval of the resource overlapping [start, end), 0 if none
+int calendarFirstOverlap(const calendar *c, int resource, int start, int end)
+{
+    int node = calendarBefore(c, resource, start + 1);
+    if (node != 0 && c->nodes[node].end > start)
+    {
+        return node;
+    }
+    // else the first interval starting after start
+    int found = 0;
+    node = c->root[resource];
+    while (node != 0)
+    {
+        if (c->nodes[node].start > start)
+        {
+            found = node;
+            node = c->nodes[node].left;
+        }
+        else
+        {
+            node = c->nodes[node].right;
+        }
+    }
+    return (found != 0 && c->nodes[found].start < end) ? found : 0;
+}
+
+// 1 if the resource is free for the whole booking, 0 if any hour is booked or outside the calendar
+int calendarIsFree(const calendar *c, int day, int resource, int start, int duration)
+{
+    start += day * DAY_HOURS;
+    if (!calendarHasHours(start, start + duration))
+    {
+        return 0;
+    }
+    return calendarOverlap(c, resource, start, start + duration) == 0;
+}
+
+// highest priority holding any hour of the booking, 0 if all free
+// hours outside the calendar can never be displaced, 127 is returned
+int calendarHighestPriority(const calendar *c, int day, int resource, int start, int duration)
+{
+    int highest = 0;
+    int end;
+    start += day * DAY_HOURS;
+    end = start + duration;
+    if (!calendarHasHours(start, end))
+    {
+        return 127;
+    }
+    int node;
+    while ((node = calendarOverlap(c, resource, start, end)) != 0)
+    {
+        if (c->nodes[node].priority > highest)
+        {
+            highest = c->nodes[node].priority;
+        }
+        end = c->nodes[node].start;
+    }
+    return highest;
+}
+
+// mark the booking on the calendar, the caller must have checked it is free
+void calendarInsert(calendar *c, int day, int resource, int start, int duration, int command, int priority)
+{
+    int node = c->freeNode;
+    if (node != 0)
+    {
+        c->freeNode = c->nodes[node].right;
+    }
+    else
+    {
+        node = ++c->nodeCount;
+    }
+    start += day * DAY_HOURS;
+    c->nodes[node] = (intervalNode){start, start + duration, command, resource, priority, 0, 0, c->heldBy[command]};
+    c->heldBy[command] = node;
+
+    int left, right;
+    treapSplit(c->nodes, c->root[resource], start, &left, &right);
+    c->root[resource] = treapMerge(c->nodes, treapMerge(c->nodes, left, node), right);
+}
+
+// take one interval off its resource
+void calendarRemove(calendar *c, int node)
+{
+    int resource = c->nodes[node].resource;
+    int left, middle, right;
+    treapSplit(c->nodes, c->root[resource], c->nodes[node].start, &left, &right);
+    treapSplit(c->nodes, right, c->nodes[node].start + 1, &middle, &right);
+    c->root[resource] = treapMerge(c->nodes, left, right);
+    c->nodes[node].command = -1;
+    c->nodes[node].right = c->freeNode;
+    c->freeNode = node;
+}
+
+// remove every interval held by the command, on all resources
+void calendarErase(calendar *c, int command)
+{
+    int node = c->heldBy[command];
+    while (node != 0)
+    {
+        // calendarRemove links the node in the free list
+        int next = c->nodes[node].nextHeld;
+        calendarRemove(c, node);
+        node = next;
+    }
+    c->heldBy[command] = 0;
+}
+
+// reject and erase every command holding an hour of the booking, in hour order
+void calendarDisplace(calendar *c, int day, int resource, int start, int duration, int *rejectedCommandIndex, int *rejectedCount)
+{
+    int node;
+    start += day * DAY_HOURS;
+    while ((node = calendarFirstOverlap(c, resource, start, start + duration)) != 0)
+    {
+        int rejectedCmd = c->nodes[node].command;
+        rejectedCommandIndex[*rejectedCount] = rejectedCmd;
+        (*rejectedCount)++;
+        calendarErase(c, rejectedCmd);
+    }
+}
+
+// bits [from, to) of a day word
+unsigned int hourMask(int from, int to)
+{
+    return (unsigned int)(((1ull << (to - from)) - 1) << from);
+}
+
+// set the hours of the intervals in the tree overlapping [start, end) in the day words from firstDay,
+// the subtrees outside the range are skipped
+void calendarMaskTree(const calendar *c, int node, int start, int end, int firstDay, unsigned int *dayMask)
+{
+    while (node != 0)
+    {
+        const intervalNode *n = &c->nodes[node];
+        if (n->start > start)
+        {
+            calendarMaskTree(c, n->left, start, end, firstDay, dayMask);
+        }
+        if (n->start >= end)
+        {
+            return;
+        }
+        int from = n->start > start ? n->start : start;
+        int to = n->end < end ? n->end : end;
+        while (from < to)
+        {
+            int day = from / DAY_HOURS - (from % DAY_HOURS < 0);
+            int hr = from - day * DAY_HOURS;
+            int last = to - day * DAY_HOURS > DAY_HOURS ? DAY_HOURS : to - day * DAY_HOURS;
+            dayMask[day - firstDay] |= hourMask(hr, last);
+            from += last - hr;
+        }
+        node = n->right;
+    }
+}
+
+// the booked hours of the resource as one word per day of [firstDay, firstDay + days), bit h is hour h
+void calendarDayMasks(const calendar *c, int resource, int firstDay, int days, unsigned int *dayMask)
+{
+    memset(dayMask, 0, days * sizeof(unsigned int));
+    calendarMaskTree(c, c->root[resource], firstDay * DAY_HOURS, (firstDay + days) * DAY_HOURS, firstDay, dayMask);
+}
+
+// reserve the booking store, and behind the bookings the rejected list and assignments of each schedule
+// the rejected list is compacted before its stale entries outnumber the others, so it holds twice the store
+// return the bookings, NULL if the store cannot be mapped
+booking *bookingStoreInit(sharedSchedule *shared, int scheduleCount)
+{
+    size_t bookingSize = (size_t)BOOKING_STORE_CAPACITY * sizeof(booking);
+    size_t indexSize = (size_t)2 * BOOKING_STORE_CAPACITY * sizeof(int);
+    size_t assignmentSize = (size_t)BOOKING_STORE_CAPACITY * sizeof(assignment);
+    char *base = mmap(NULL, bookingSize + scheduleCount * (indexSize + assignmentSize), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    int i;
+    if (base == MAP_FAILED)
+    {
+        return NULL;
+    }
+    for (i = 0; i < scheduleCount; i++)
+    {
+        char *lists = base + bookingSize + i * (indexSize + assignmentSize);
+        shared->schedules[i].rejectedCommandIndex = (int *)lists;
+        shared->schedules[i].assigned = (assignment *)(lists + indexSize);
+    }
+    return (booking *)base;
+}
+
+//  -- Scheduling policies --
+// each schedule is kept by a policy that only touches its own calendar, rejected list and assignments,
+// so the policies place the same bookings at the same time, on their own threads
+// a new policy is a set of hooks added to policies, printBookings selects it by name
+
+// a class of units a booking can ask for, its units are the ones of its type in the catalog
+typedef struct resourceClass
+{
+    resource_type type;
+    // the resource_type a room booking has to take with this one, -1 if it can be taken alone
+    int pairedWith;
+} resourceClass;
+
+// the classes in the order a booking claims them
+// a unit fits a request by its capacity for a room, by its model for a device
+const resourceClass resourceClasses[] = {
+    {roomResource, -1},
+    {projectorResource, screenResource},
+    {screenResource, projectorResource},
+    {webcamResource, monitorResource},
+    {monitorResource, webcamResource},
+};
+#define resourceClassAmount ((int)(sizeof(resourceClasses) / sizeof(resourceClass)))
+
+// what a booking asks the policies for, decoded once by the scheduling module
+typedef struct request
+{
+    // event_priority of the booking, none if it cannot be placed at all
+    int type;
+    // day ordinal, start hour and number of hours
+    int day;
+    int start;
+    int duration;
+    int participants;
+    // requested model of each resource_type, -1 if the type is not requested
+    int model[screenResource + 1];
+} request;
+
+// the hooks of a policy
+typedef struct schedulePolicy
+{
+    // name given to printBookings, after the dash
+    const char *name;
+    // name in the output report
+    const char *title;
+    // name in the analysis report
+    const char *label;
+    // set up the schedule when the scheduling module starts
+    void (*init)(policySchedule *s);
+    // place the command of the store on the schedule: a booking is placed or rejected,
+    // a cancellation or a move first takes the booking it changes off the schedule
+    void (*place)(policySchedule *s, const request *r, const booking *bookings, int command);
+    // complete the schedule before printBookings publishes it, NULL if it is always complete
+    void (*finalize)(policySchedule *s, const booking *bookings, int numOfCommand);
+} schedulePolicy;
+
+// decode the booking, return 0 if its devices cannot be booked together
+int decodeRequest(const booking *b, request *r)
+{
+    int n;
+    // a cancellation places nothing
+    r->type = b->type == cancelBooking ? none : b->type;
+    r->day = b->day;
+    r->start = bookingStartHour(b);
+    r->duration = bookingHours(b);
+    r->participants = b->participants;
+    for (n = 0; n <= screenResource; n++)
+    {
+        r->model[n] = -1;
+    }
+    for (n = 0; n < b->deviceCount; n++)
+    {
+        r->model[resourceType(b->device[n])] = b->device[n];
+    }
+    if (b->type == bookDevice || b->type == cancelBooking)
+    {
+        return 1;
+    }
+    // a room booking takes each device with its pair, like a projector with a screen
+    for (n = 0; n < resourceClassAmount; n++)
+    {
+        const resourceClass *k = &resourceClasses[n];
+        if (r->model[k->type] >= 0 && k->pairedWith >= 0 && r->model[k->pairedWith] < 0)
+        {
+            r->type = none;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 1 if the request takes a unit of the class
+int requestNeeds(const request *r, const resourceClass *k)
+{
+    return k->type == roomResource ? r->type != bookDevice : r->model[k->type] >= 0;
+}
+
+// 1 if the unit can hold the request
+int unitFits(const request *r, const resourceClass *k, int resource)
+{
+    return k->type == roomResource ? r->participants <= catalog.roomCapacity[resource - roomResourceStart] : resourceModel[resource] == r->model[k->type];
+}
+
+// the unit of the class given to the request, -1 if none
+// a free unit is taken first, else with displace the unit held by the lowest priority under the request's
+int selectUnit(const policySchedule *s, const request *r, const resourceClass *k, int displace)
+{
+    int resource, selected = -1, lowest = 255;
+    for (resource = catalog.typeStart[k->type]; resource < catalog.typeStart[k->type + 1]; resource++)
+    {
+        if (!unitFits(r, k, resource))
+        {
+            continue;
+        }
+        if (!displace)
+        {
+            if (calendarIsFree(&s->cal, r->day, resource, r->start, r->duration))
+            {
+                return resource;
+            }
+            continue;
+        }
+        int highest = calendarHighestPriority(&s->cal, r->day, resource, r->start, r->duration);
+        if (highest == 0)
+        {
+            return resource;
+        }
+        if (highest < r->type && highest < lowest)
+        {
+            lowest = highest;
+            selected = resource;
+        }
+    }
+    return selected;
+}
+
+// the unit of each class the request needs in units, by resource_type, -1 for the others
+// return 0 if a class has no unit for it
+int selectBundle(const policySchedule *s, const request *r, int displace, int *units)
+{
+    int n;
+    for (n = 0; n <= screenResource; n++)
+    {
+        units[n] = -1;
+    }
+    if (r->type == none)
+    {
+        return 0;
+    }
+    for (n = 0; n < resourceClassAmount; n++)
+    {
+        const resourceClass *k = &resourceClasses[n];
+        if (requestNeeds(r, k) && (units[k->type] = selectUnit(s, r, k, displace)) < 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// put the booking on the unit, rejecting the bookings holding it with displace
+void claimUnit(policySchedule *s, const request *r, int resource, int command, int displace)
+{
+    if (displace)
+    {
+        calendarDisplace(&s->cal, r->day, resource, r->start, r->duration, s->rejectedCommandIndex, &s->rejectedCount);
+    }
+    calendarInsert(&s->cal, r->day, resource, r->start, r->duration, command, r->type);
+}
+
+// drop the stale entries of the rejected list, the others keep their order
+void compactRejected(policySchedule *s)
+{
+    int i, count = 0;
+    for (i = 0; i < s->rejectedCount; i++)
+    {
+        int command = s->rejectedCommandIndex[i];
+        if (s->assigned[command].rejectedAt == i)
+        {
+            s->assigned[command].rejectedAt = count;
+            s->rejectedCommandIndex[count++] = command;
+        }
+    }
+    s->rejectedCount = count;
+    s->staleCount = 0;
+}
+
+// take a cancelled or moved booking off the schedule, it is then neither accepted nor rejected
+// only its own intervals are touched
+void withdrawBooking(policySchedule *s, int command)
+{
+    assignment *a = &s->assigned[command];
+    if (a->accepted)
+    {
+        calendarErase(&s->cal, command);
+    }
+    if (a->rejectedAt >= 0)
+    {
+        s->staleCount++;
+    }
+    a->accepted = 0;
+    a->rejectedAt = -1;
+    s->withdrawn++;
+}
+
+// undo withdrawBooking, the booking gets back the units it held, which nothing has taken since
+void restoreBooking(policySchedule *s, const booking *bookings, int command, const assignment *held)
+{
+    int n;
+    request r;
+    if (held->accepted)
+    {
+        decodeRequest(&bookings[command], &r);
+        if (held->room >= 0)
+        {
+            calendarInsert(&s->cal, r.day, roomResourceStart + held->room, r.start, r.duration, command, r.type);
+        }
+        for (n = 0; n < bookings[command].deviceCount; n++)
+        {
+            calendarInsert(&s->cal, r.day, held->device[n], r.start, r.duration, command, r.type);
+        }
+    }
+    if (held->rejectedAt >= 0)
+    {
+        s->staleCount--;
+    }
+    s->assigned[command] = *held;
+    s->withdrawn--;
+}
+
+// priority first, then arrival order
+int compareReadmission(const void *a, const void *b)
+{
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+// the bookings displaced by a withdrawn booking get the units it has left, if they are still free
+// they displace nothing in turn, so a change only touches the bookings it had displaced
+void readmitDisplaced(policySchedule *s, const booking *bookings, int command)
+{
+    int count = 0, i, t, displaced;
+    for (displaced = s->assigned[command].displaced; displaced >= 0; displaced = s->assigned[displaced].nextDisplaced)
+    {
+        count++;
+    }
+    long long *order = malloc((count + 1) * sizeof(long long));
+    if (order == NULL)
+    {
+        return;
+    }
+    count = 0;
+    for (displaced = s->assigned[command].displaced; displaced >= 0; displaced = s->assigned[displaced].nextDisplaced)
+    {
+        // a booking withdrawn since is no longer rejected
+        if (s->assigned[displaced].rejectedAt >= 0 && s->assigned[displaced].evictedBy == command)
+        {
+            order[count++] = (long long)(addConference - bookings[displaced].type) << 32 | displaced;
+        }
+    }
+    s->assigned[command].displaced = -1;
+    qsort(order, count, sizeof(long long), compareReadmission);
+    for (i = 0; i < count; i++)
+    {
+        int id = order[i] & 0xffffffff, units[screenResource + 1];
+        request r;
+        if (!decodeRequest(&bookings[id], &r) || !selectBundle(s, &r, 0, units))
+        {
+            continue;
+        }
+        for (t = 0; t < resourceClassAmount; t++)
+        {
+            if (units[resourceClasses[t].type] >= 0)
+            {
+                claimUnit(s, &r, units[resourceClasses[t].type], id, 0);
+            }
+        }
+        assignBooking(&s->assigned[id], &bookings[id], units);
+        s->assigned[id].rejectedAt = -1;
+        s->staleCount++;
+    }
+    free(order);
+}
+
+// place the command of the store on the schedule
+// with displace a booking takes units from lower priority bookings, which are rejected,
+// and the ones a cancelled or moved booking had displaced are given its units back
+// a move is tried with the booking off the schedule, so it can overlap its old hours,
+// and the booking is put back as it was if the move does not fit
+void placeBooking(policySchedule *s, const request *r, const booking *bookings, int command, int displace)
+{
+    const booking *b = &bookings[command];
+    int units[screenResource + 1];
+    // the booking a change applies to, as it stands on this schedule
+    int root = b->target != 0 ? bookingRoot(bookings, command) : command;
+    int changed = b->target != 0 ? s->assigned[root].current : -1;
+    if (2 * s->staleCount > s->rejectedCount)
+    {
+        compactRejected(s);
+    }
+    assignment held;
+    if (changed >= 0)
+    {
+        held = s->assigned[changed];
+        withdrawBooking(s, changed);
+    }
+    if (b->type == cancelBooking)
+    {
+        s->assigned[command] = (assignment){-1, {-1, -1}, 0, -1, -1, -1, -1, -1};
+        s->assigned[root].current = -1;
+        s->withdrawn++;
+    }
+    else if (!selectBundle(s, r, displace, units))
+    {
+        if (changed >= 0)
+        {
+            restoreBooking(s, bookings, changed, &held);
+            changed = -1;
+        }
+        s->assigned[command] = (assignment){-1, {-1, -1}, 0, -1, s->rejectedCount, -1, -1, -1};
+        s->rejectedCommandIndex[s->rejectedCount++] = command;
+    }
+    else
+    {
+        int i, rejectedBefore = s->rejectedCount;
+        for (i = 0; i < resourceClassAmount; i++)
+        {
+            if (units[resourceClasses[i].type] >= 0)
+            {
+                claimUnit(s, r, units[resourceClasses[i].type], command, displace);
+            }
+        }
+        assignBooking(&s->assigned[command], b, units);
+        s->assigned[command].rejectedAt = -1;
+        s->assigned[command].displaced = -1;
+        s->assigned[command].current = -1;
+        s->assigned[root].current = command;
+        // the bookings displaced by this one
+        for (i = rejectedBefore; i < s->rejectedCount; i++)
+        {
+            assignment *a = &s->assigned[s->rejectedCommandIndex[i]];
+            a->accepted = 0;
+            a->evictedBy = command;
+            a->rejectedAt = i;
+            a->nextDisplaced = s->assigned[command].displaced;
+            s->assigned[command].displaced = s->rejectedCommandIndex[i];
+        }
+    }
+    if (b->target == 0)
+    {
+        s->assigned[command].current = command;
+    }
+    if (changed >= 0 && displace)
+    {
+        readmitDisplaced(s, bookings, changed);
+    }
+}
+
+// an empty schedule
+void clearSchedule(policySchedule *s)
+{
+    s->rejectedCount = 0;
+    s->staleCount = 0;
+    s->withdrawn = 0;
+}
+
+// first come first serve: a booking only takes free units
+void placeFCFS(policySchedule *s, const request *r, const booking *bookings, int command)
+{
+    placeBooking(s, r, bookings, command, 0);
+}
+
+// priority: a booking takes units from bookings of a lower priority type, which are rejected
+void placePriority(policySchedule *s, const request *r, const booking *bookings, int command)
+{
+    placeBooking(s, r, bookings, command, 1);
+}
+
+//  the optimal policy: the most booking hours accepted
+// bookings only compete with the bookings overlapping them on a resource they could use,
+// so they are split into independent groups, searched one after the other
+// a group is searched in start order, a unit then only matters by the hour it is busy until:
+// the free units of one model are the same choice, and so are the free rooms of one capacity
+// the first descent of the search is the greedy schedule, a branch is cut when the hours it can
+// still reach are not above the best schedule found, and the search stops at the time budget
+
+// default wall clock time of the search on each printBookings, in milliseconds
+#define OPTIMAL_TIME_BUDGET_MS 2000
+
+// the time budget in use, set by -optBudget <ms> before the modules start
+long long optimalBudget = OPTIMAL_TIME_BUDGET_MS;
+
+// a booking of a group, in absolute hours
+typedef struct optimalItem
+{
+    int start;
+    int end;
+    int command;
+    // the units the booking holds, then the rooms it fits in and its device models:
+    // bookings with the same hours and profile are the same choice
+    long long profile;
+} optimalItem;
+
+// the branches of one booking in the search:
+// accept it in a free room of each capacity, smallest first, then reject it
+typedef struct optimalFrame
+{
+    // 1 if the booking has the free devices it needs
+    char possible;
+    // 0 before the first branch, 1 on an accept branch, 2 on the reject branch
+    char stage;
+    // capacity of the room of the accept branch
+    int capacity;
+    // unit held of each resource_type, -1 if none
+    short unit[screenResource + 1];
+    // 1 if the branch taken accepts the booking
+    char accepted;
+    // the hours of the units before the booking took them
+    int savedBusy[screenResource + 1];
+    int savedTail[screenResource + 1];
+} optimalFrame;
+
+typedef struct optimalSearch
+{
+    // decoded bookings, by command
+    const request *requests;
+    // the group, in start order
+    const optimalItem *items;
+    int count;
+    // hours of the items [i, count)
+    long long *suffixHours;
+    // hours the resources can hold from the start of item i
+    long long *capacityFrom;
+    optimalFrame *frames;
+    // the best schedule found, by command
+    char *bestAccepted;
+    short (*bestUnit)[screenResource + 1];
+    // the frames from dirty on changed since the best schedule was saved
+    int dirty;
+    // end of the last booking on each unit
+    int *busyUntil;
+    // end of the last booking counted on each unit, a booking is counted on its first unit only
+    int *tailEnd;
+    long long accepted;
+    long long best;
+    // the most hours of the branches left when the time is over
+    long long openBound;
+    long long nodes;
+    long long deadline;
+    int timedOut;
+} optimalSearch;
+
+// a booking of a group starts or ends
+typedef struct optimalEvent
+{
+    int hour;
+    // 1 at the start, -1 at the end
+    int change;
+    int item;
+} optimalEvent;
+
+long long monotonicMilliseconds(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// in start order, and on one hour the bookings holding fewer units first, then the longer first
+int compareOptimalItem(const void *a, const void *b)
+{
+    const optimalItem *x = a, *y = b;
+    if (x->start != y->start)
+    {
+        return x->start < y->start ? -1 : 1;
+    }
+    if (x->profile != y->profile)
+    {
+        return x->profile < y->profile ? -1 : 1;
+    }
+    if (x->end != y->end)
+    {
+        return x->end > y->end ? -1 : 1;
+    }
+    return x->command - y->command;
+}
+
+// 12 bits for each count and model, the catalog has at most CATALOG_UNIT_LIMIT units
+long long requestProfile(const request *r)
+{
+    int t, k;
+    long long units = 0, rooms = 0, models = 0;
+    if (r->type != bookDevice)
+    {
+        units++;
+        for (k = 0; k < roomAmount; k++)
+        {
+            rooms += r->participants <= catalog.roomCapacity[k];
+        }
+    }
+    for (t = webcamResource; t <= screenResource; t++)
+    {
+        units += r->model[t] >= 0;
+        models = models << 12 | (r->model[t] + 1);
+    }
+    return units << 60 | rooms << 48 | models;
+}
+
+int compareOptimalEvent(const void *a, const void *b)
+{
+    const optimalEvent *x = a, *y = b;
+    return x->hour < y->hour ? -1 : x->hour > y->hour;
+}
+
+int groupRoot(int *parent, int item)
+{
+    while (parent[item] != item)
+    {
+        parent[item] = parent[parent[item]];
+        item = parent[item];
+    }
+    return item;
+}
+
+// model of the first device of the request, -1 if it has none
+int requestFirstModel(const request *r)
+{
+    int t;
+    for (t = webcamResource; t <= screenResource; t++)
+    {
+        if (r->model[t] >= 0)
+        {
+            return r->model[t];
+        }
+    }
+    return -1;
+}
+
+// the most booking hours from the start of each item, one hour at a time:
+// the rooms hold at most a booking each, the large rooms take the bookings too big for the small ones,
+// and a device model holds at most one booking per unit
+void optimalCapacity(optimalSearch *o, const int *unitsOfModel)
+{
+    int n = o->count, i, k, m, segmentCount = 0;
+    int smallest = roomAmount > 0 ? catalog.roomCapacity[0] : 0, largeRooms = 0;
+    optimalEvent *events = malloc(2 * n * sizeof(optimalEvent));
+    long long *segmentHours = malloc(2 * n * sizeof(long long));
+    int *segmentStart = malloc(2 * n * sizeof(int));
+    int deviceUse[resourceAmount], deviceOnly[resourceAmount];
+    int roomActive = 0, smallActive = 0, noDeviceActive = 0;
+    memset(deviceUse, 0, sizeof(deviceUse));
+    memset(deviceOnly, 0, sizeof(deviceOnly));
+    for (k = 1; k < roomAmount; k++)
+    {
+        smallest = catalog.roomCapacity[k] < smallest ? catalog.roomCapacity[k] : smallest;
+    }
+    for (k = 0; k < roomAmount; k++)
+    {
+        largeRooms += catalog.roomCapacity[k] > smallest;
+    }
+    for (i = 0; i < n; i++)
+    {
+        events[2 * i] = (optimalEvent){o->items[i].start, 1, i};
+        events[2 * i + 1] = (optimalEvent){o->items[i].end, -1, i};
+    }
+    qsort(events, 2 * n, sizeof(optimalEvent), compareOptimalEvent);
+    for (i = 0; i < 2 * n; i++)
+    {
+        const request *r = &o->requests[o->items[events[i].item].command];
+        int change = events[i].change;
+        if (r->type != none)
+        {
+            m = requestFirstModel(r);
+            if (r->type != bookDevice)
+            {
+                roomActive += change;
+                smallActive += r->participants <= smallest ? change : 0;
+                noDeviceActive += m < 0 ? change : 0;
+            }
+            else
+            {
+                deviceOnly[m] += change;
+            }
+            if (m >= 0)
+            {
+                deviceUse[m] += change;
+            }
+        }
+        if (i + 1 < 2 * n && events[i + 1].hour == events[i].hour)
+        {
+            continue;
+        }
+        // the hours until the next event hold the same bookings
+        int rooms = roomActive < roomAmount ? roomActive : roomAmount;
+        rooms = smallActive + largeRooms < rooms ? smallActive + largeRooms : rooms;
+        int devices = 0, shared = 0;
+        for (m = webcamResourceStart; m < resourceAmount; m++)
+        {
+            devices += deviceOnly[m] < unitsOfModel[m] ? deviceOnly[m] : unitsOfModel[m];
+            shared += deviceUse[m] < unitsOfModel[m] ? deviceUse[m] : unitsOfModel[m];
+        }
+        int held = rooms + devices;
+        int heldByDevice = (noDeviceActive < rooms ? noDeviceActive : rooms) + shared;
+        held = heldByDevice < held ? heldByDevice : held;
+        segmentStart[segmentCount] = events[i].hour;
+        segmentHours[segmentCount++] = i + 1 < 2 * n ? (long long)held * (events[i + 1].hour - events[i].hour) : 0;
+    }
+    for (k = segmentCount - 2; k >= 0; k--)
+    {
+        segmentHours[k] += segmentHours[k + 1];
+    }
+    for (i = 0, k = 0; i < n; i++)
+    {
+        while (segmentStart[k] < o->items[i].start)
+        {
+            k++;
+        }
+        o->capacityFrom[i] = segmentHours[k];
+    }
+    free(events);
+    free(segmentHours);
+    free(segmentStart);
+}
+
+// the most hours a schedule through item i can have
+long long optimalBound(const optimalSearch *o, int i)
+{
+    int u, start;
+    long long after = 0;
+    if (i == o->count)
+    {
+        return o->accepted;
+    }
+    start = o->items[i].start;
+    for (u = 0; u < resourceAmount; u++)
+    {
+        if (o->tailEnd[u] > start)
+        {
+            after += o->tailEnd[u] - start;
+        }
+    }
+    long long reach = after + o->suffixHours[i];
+    if (reach > o->capacityFrom[i])
+    {
+        reach = o->capacityFrom[i];
+    }
+    return o->accepted - after + reach;
+}
+
+// prepare the branches of item i: the device units it would hold and if it can be accepted at all
+void optimalOptions(const optimalSearch *o, int i, optimalFrame *f)
+{
+    const request *r = &o->requests[o->items[i].command];
+    int start = o->items[i].start, t, u, k;
+    f->stage = 0;
+    f->capacity = -1;
+    for (t = 0; t <= screenResource; t++)
+    {
+        f->unit[t] = -1;
+    }
+    // a booking the same as the one before is not taken if that one was not
+    const optimalItem *previous = i > 0 ? &o->items[i - 1] : NULL;
+    f->possible = r->type != none;
+    if (previous != NULL && !o->frames[i - 1].accepted && previous->start == o->items[i].start && previous->end == o->items[i].end && previous->profile == o->items[i].profile)
+    {
+        f->possible = 0;
+    }
+    for (k = 0; k < resourceClassAmount && f->possible; k++)
+    {
+        const resourceClass *c = &resourceClasses[k];
+        if (c->type == roomResource || !requestNeeds(r, c))
+        {
+            continue;
+        }
+        for (u = catalog.typeStart[c->type]; u < catalog.typeStart[c->type + 1] && f->unit[c->type] < 0; u++)
+        {
+            if (unitFits(r, c, u) && o->busyUntil[u] <= start)
+            {
+                f->unit[c->type] = u;
+            }
+        }
+        f->possible = f->unit[c->type] >= 0;
+    }
+}
+
+// move item i to its next branch, the free room of the next larger capacity or else reject,
+// 0 if every branch was taken
+int optimalNextOption(const optimalSearch *o, int i, optimalFrame *f)
+{
+    const request *r = &o->requests[o->items[i].command];
+    int start = o->items[i].start, k, room = -1;
+    if (f->stage == 2)
+    {
+        return 0;
+    }
+    if (f->possible && r->type == bookDevice && f->stage == 0)
+    {
+        f->stage = 1;
+        return 1;
+    }
+    for (k = 0; k < roomAmount && f->possible && r->type != bookDevice; k++)
+    {
+        int capacity = catalog.roomCapacity[k];
+        if (r->participants > capacity || capacity <= f->capacity || o->busyUntil[roomResourceStart + k] > start)
+        {
+            continue;
+        }
+        if (room < 0 || capacity < catalog.roomCapacity[room])
+        {
+            room = k;
+        }
+    }
+    if (room < 0)
+    {
+        f->stage = 2;
+        return 1;
+    }
+    f->stage = 1;
+    f->capacity = catalog.roomCapacity[room];
+    f->unit[roomResource] = roomResourceStart + room;
+    return 1;
+}
+
+// take the current branch of item i
+void optimalApply(optimalSearch *o, int i, optimalFrame *f)
+{
+    const optimalItem *item = &o->items[i];
+    int t, counted = 0;
+    f->accepted = f->stage == 1;
+    if (!f->accepted)
+    {
+        return;
+    }
+    for (t = 0; t <= screenResource; t++)
+    {
+        int u = f->unit[t];
+        if (u < 0)
+        {
+            continue;
+        }
+        f->savedBusy[t] = o->busyUntil[u];
+        f->savedTail[t] = o->tailEnd[u];
+        o->busyUntil[u] = item->end;
+        if (!counted)
+        {
+            o->tailEnd[u] = item->end;
+            counted = 1;
+        }
+    }
+    o->accepted += item->end - item->start;
+}
+
+// give back the branch taken on item i
+void optimalUndo(optimalSearch *o, int i, optimalFrame *f)
+{
+    int t;
+    if (!f->accepted)
+    {
+        return;
+    }
+    for (t = 0; t <= screenResource; t++)
+    {
+        if (f->unit[t] >= 0)
+        {
+            o->busyUntil[f->unit[t]] = f->savedBusy[t];
+            o->tailEnd[f->unit[t]] = f->savedTail[t];
+        }
+    }
+    o->accepted -= o->items[i].end - o->items[i].start;
+    f->accepted = 0;
+}
+
+// search the group until it is done or the deadline, the best schedule is in bestAccepted and bestUnit
+void optimalSearchGroup(optimalSearch *o)
+{
+    int depth = 0, entering = 1, u, i;
+    for (u = 0; u < resourceAmount; u++)
+    {
+        o->busyUntil[u] = CALENDAR_FIRST_DAY * DAY_HOURS;
+        o->tailEnd[u] = CALENDAR_FIRST_DAY * DAY_HOURS;
+    }
+    o->accepted = 0;
+    o->best = -1;
+    o->openBound = 0;
+    o->timedOut = 0;
+    o->dirty = 0;
+    while (depth >= 0)
+    {
+        optimalFrame *f = &o->frames[depth];
+        if (entering)
+        {
+            entering = 0;
+            if (depth == o->count)
+            {
+                if (o->accepted > o->best)
+                {
+                    o->best = o->accepted;
+                    for (i = o->dirty; i < o->count; i++)
+                    {
+                        o->bestAccepted[o->items[i].command] = o->frames[i].accepted;
+                        memcpy(o->bestUnit[o->items[i].command], o->frames[i].unit, sizeof(o->frames[i].unit));
+                    }
+                    o->dirty = o->count;
+                }
+                depth--;
+                continue;
+            }
+            // the greedy schedule is always completed before the deadline is checked
+            if (o->best >= 0 && (++o->nodes & 4095) == 0 && monotonicMilliseconds() >= o->deadline)
+            {
+                o->timedOut = 1;
+                break;
+            }
+            if (o->best >= 0 && optimalBound(o, depth) <= o->best)
+            {
+                depth--;
+                continue;
+            }
+            optimalOptions(o, depth, f);
+        }
+        optimalUndo(o, depth, f);
+        if (!optimalNextOption(o, depth, f))
+        {
+            depth--;
+            continue;
+        }
+        optimalApply(o, depth, f);
+        if (depth < o->dirty)
+        {
+            o->dirty = depth;
+        }
+        depth++;
+        entering = 1;
+    }
+    if (!o->timedOut)
+    {
+        return;
+    }
+    // the hours the branches left could still reach
+    o->openBound = optimalBound(o, depth);
+    for (depth--; depth >= 0; depth--)
+    {
+        optimalFrame *f = &o->frames[depth];
+        optimalUndo(o, depth, f);
+        while (optimalNextOption(o, depth, f))
+        {
+            optimalApply(o, depth, f);
+            long long bound = optimalBound(o, depth + 1);
+            o->openBound = bound > o->openBound ? bound : o->openBound;
+            optimalUndo(o, depth, f);
+        }
+    }
+}
+
+// replace the schedule by the one with the most booking hours found within the time budget
+void finalizeOptimal(policySchedule *s, const booking *bookings, int numOfCommand)
+{
+    long long deadline = monotonicMilliseconds() + optimalBudget;
+    int n = numOfCommand, i, k, m, u, t;
+    request *requests = malloc((n + 1) * sizeof(request));
+    optimalItem *items = malloc((n + 1) * sizeof(optimalItem));
+    optimalItem *grouped = malloc((n + 1) * sizeof(optimalItem));
+    int *parent = malloc((n + 1) * sizeof(int));
+    int *groupStart = calloc(n + 2, sizeof(int));
+    long long *suffixHours = malloc((n + 1) * sizeof(long long));
+    long long *capacityFrom = malloc((n + 1) * sizeof(long long));
+    optimalFrame *frames = calloc(n + 1, sizeof(optimalFrame));
+    char *bestAccepted = calloc(n + 1, 1);
+    short (*bestUnit)[screenResource + 1] = malloc((n + 1) * sizeof(*bestUnit));
+    int *busyUntil = malloc(resourceAmount * sizeof(int));
+    int *tailEnd = malloc(resourceAmount * sizeof(int));
+    if (!requests || !items || !grouped || !parent || !groupStart || !suffixHours || !capacityFrom || !frames || !bestAccepted || !bestUnit || !busyUntil || !tailEnd)
+    {
+        // the greedy schedule is kept as it is
+        printf("Scheduling module Error, out of memory, the optimal schedule is the greedy one\n");
+        free(requests), free(items), free(grouped), free(parent), free(groupStart);
+        free(suffixHours), free(capacityFrom), free(frames), free(bestAccepted), free(bestUnit);
+        free(busyUntil), free(tailEnd);
+        return;
+    }
+
+    int unitsOfModel[resourceAmount];
+    memset(unitsOfModel, 0, sizeof(unitsOfModel));
+    for (u = webcamResourceStart; u < resourceAmount; u++)
+    {
+        unitsOfModel[resourceModel[u]]++;
+    }
+    for (i = 0; i < n; i++)
+    {
+        decodeRequest(&bookings[i], &requests[i]);
+        // cancellations and the bookings cancelled or moved take no hours,
+        // and a move that did not fit stays rejected, the booking it would move keeps its hours
+        if ((!s->assigned[i].accepted && s->assigned[i].rejectedAt < 0) || (bookings[i].target != 0 && s->assigned[bookingRoot(bookings, i)].current != i))
+        {
+            requests[i].type = none;
+        }
+        items[i].start = requests[i].day * DAY_HOURS + requests[i].start;
+        items[i].end = items[i].start + requests[i].duration;
+        items[i].command = i;
+        items[i].profile = requestProfile(&requests[i]);
+    }
+    qsort(items, n, sizeof(optimalItem), compareOptimalItem);
+
+    // join the bookings overlapping on the rooms, then on each device model
+    for (i = 0; i < n; i++)
+    {
+        parent[i] = i;
+    }
+    for (m = -1; m < (int)resourceAmount; m++)
+    {
+        if (m >= 0 && (m < webcamResourceStart || resourceModel[m] != m))
+        {
+            continue;
+        }
+        int last = -1, lastEnd = 0;
+        for (i = 0; i < n; i++)
+        {
+            const request *r = &requests[items[i].command];
+            if (r->type == none || (m < 0 ? r->type == bookDevice : r->model[resourceType(m)] != m))
+            {
+                continue;
+            }
+            if (last >= 0 && items[i].start < lastEnd)
+            {
+                parent[groupRoot(parent, i)] = groupRoot(parent, last);
+            }
+            if (last < 0 || items[i].end > lastEnd)
+            {
+                last = i;
+                lastEnd = items[i].end;
+            }
+        }
+    }
+    // the groups one after the other, each in start order
+    for (i = 0; i < n; i++)
+    {
+        groupStart[groupRoot(parent, i) + 1]++;
+    }
+    for (i = 0; i < n; i++)
+    {
+        groupStart[i + 1] += groupStart[i];
+    }
+    for (i = 0; i < n; i++)
+    {
+        grouped[groupStart[groupRoot(parent, i)]++] = items[i];
+    }
+    for (i = n; i > 0; i--)
+    {
+        groupStart[i] = groupStart[i - 1];
+    }
+    groupStart[0] = 0;
+
+    long long best = 0, gap = 0;
+    int searched = 0;
+    optimalSearch search;
+    search.requests = requests;
+    search.bestAccepted = bestAccepted;
+    search.bestUnit = bestUnit;
+    search.busyUntil = busyUntil;
+    search.tailEnd = tailEnd;
+    search.nodes = 0;
+    for (k = 0; k < n; k++)
+    {
+        int first = groupStart[k], count = groupStart[k + 1] - groupStart[k];
+        if (count == 0)
+        {
+            continue;
+        }
+        search.items = grouped + first;
+        search.count = count;
+        search.suffixHours = suffixHours + first;
+        search.capacityFrom = capacityFrom + first;
+        search.frames = frames;
+        suffixHours[first + count - 1] = 0;
+        for (i = count - 1; i >= 0; i--)
+        {
+            const optimalItem *item = &grouped[first + i];
+            long long hours = requests[item->command].type == none ? 0 : item->end - item->start;
+            suffixHours[first + i] = hours + (i + 1 < count ? suffixHours[first + i + 1] : 0);
+        }
+        optimalCapacity(&search, unitsOfModel);
+        // the time left is shared by the bookings left
+        long long now = monotonicMilliseconds();
+        search.deadline = now + (deadline > now ? (deadline - now) * count / (n - searched) : 0);
+        memset(frames, 0, (count + 1) * sizeof(optimalFrame));
+        optimalSearchGroup(&search);
+        searched += count;
+        best += search.best;
+        if (search.timedOut && search.openBound > search.best)
+        {
+            gap += search.openBound - search.best;
+        }
+    }
+
+    // the schedule is rebuilt from the best one found, the withdrawn bookings stay off it
+    calendarClear(&s->cal, n);
+    s->rejectedCount = 0;
+    s->staleCount = 0;
+    for (i = 0; i < n; i++)
+    {
+        const request *r = &requests[i];
+        if (!s->assigned[i].accepted && s->assigned[i].rejectedAt < 0)
+        {
+            continue;
+        }
+        if (!bestAccepted[i])
+        {
+            s->assigned[i] = (assignment){-1, {-1, -1}, 0, -1, s->rejectedCount, -1, -1, s->assigned[i].current};
+            s->rejectedCommandIndex[s->rejectedCount++] = i;
+            continue;
+        }
+        int unit[screenResource + 1];
+        for (t = 0; t <= screenResource; t++)
+        {
+            unit[t] = bestUnit[i][t];
+            if (unit[t] >= 0)
+            {
+                calendarInsert(&s->cal, r->day, unit[t], r->start, r->duration, i, r->type);
+            }
+        }
+        assignBooking(&s->assigned[i], &bookings[i], unit);
+        s->assigned[i].rejectedAt = -1;
+        s->assigned[i].displaced = -1;
+    }
+    if (gap == 0)
+    {
+        printf("-> [Optimal: %lld booking hours]\n", best);
+    }
+    else
+    {
+        printf("-> [Optimal: %lld booking hours, at most %lld below the optimum]\n", best, gap);
+    }
+
+    free(requests);
+    free(items);
+    free(grouped);
+    free(parent);
+    free(groupStart);
+    free(suffixHours);
+    free(capacityFrom);
+    free(frames);
+    free(bestAccepted);
+    free(bestUnit);
+    free(busyUntil);
+    free(tailEnd);
+}
+
+// the policies, in the order of the reports
+const schedulePolicy policies[] = {
+    {"fcfs", "FCFS", "FCFS", clearSchedule, placeFCFS, NULL},
+    {"prio", "Priority", "PRIO", clearSchedule, placePriority, NULL},
+    // placed like FCFS as bookings arrive, searched again on printBookings
+    {"opt", "Optimal", "OPT", clearSchedule, placeFCFS, finalizeOptimal},
+};
+#define policyAmount ((int)(sizeof(policies) / sizeof(schedulePolicy)))
+_Static_assert(sizeof(policies) / sizeof(schedulePolicy) <= POLICY_LIMIT, "too many policies");
+
+// set of policies of printBookings from its words: -ALL or a list of -name
+// -ALL is the policies placed as bookings arrive, the search of -opt takes up to its time budget so it is named
+// return NULL, or what is wrong
+const char *parsePolicies(char **words, int wordCount, unsigned int *policyMask)
+{
+    int i, p;
+    if (wordCount < 2)
+    {
+        return "printBookings needs a mode";
+    }
+    *policyMask = 0;
+    for (i = 1; i < wordCount; i++)
+    {
+        if (strcmp(words[i], "-ALL") == 0)
+        {
+            for (p = 0; p < policyAmount; p++)
+            {
+                if (policies[p].finalize == NULL)
+                {
+                    *policyMask |= 1u << p;
+                }
+            }
+            continue;
+        }
+        for (p = 0; p < policyAmount; p++)
+        {
+            if (words[i][0] == '-' && strcmp(words[i] + 1, policies[p].name) == 0)
+            {
+                break;
+            }
+        }
+        if (p == policyAmount)
+        {
+            return "unknown mode, must be -ALL (fcfs and prio) or a list of -fcfs -prio -opt";
+        }
+        *policyMask |= 1u << p;
+    }
+    return NULL;
+}
+
+// the bookings [first, last) to place on one schedule
+typedef struct policyRun
+{
+    const schedulePolicy *policy;
+    policySchedule *schedule;
+    const request *requests;
+    const booking *bookings;
+    int first;
+    int last;
+} policyRun;
+
+void *runPolicy(void *arg)
+{
+    const policyRun *run = arg;
+    int command;
+    for (command = run->first; command < run->last; command++)
+    {
+        run->policy->place(run->schedule, &run->requests[command - run->first], run->bookings, command);
+    }
+    return NULL;
+}
+
+// the least bookings worth a thread per policy, a few bookings are placed quicker than a thread starts
+#define SCHEDULE_THREAD_MIN_WORK 64
+
+// place the bookings [first, last) on the schedule of every policy, each policy but the first on its own thread
+// return when all the policies are done
+void scheduleBookings(policySchedule *schedules, const booking *bookings, int first, int last)
+{
+    int i;
+    request *requests = malloc((last - first + 1) * sizeof(request));
+    policyRun runs[policyAmount];
+    pthread_t threads[policyAmount];
+    int started[policyAmount];
+    if (requests == NULL)
+    {
+        printf("Scheduling module: out of memory\n");
+        return;
+    }
+    for (i = first; i < last; i++)
+    {
+        printf("%d: %s\n", i + 1, commandName(&bookings[i]));
+        if (!decodeRequest(&bookings[i], &requests[i - first]))
+        {
+            printf("invalid input at Scheduling module(device not in pair)\n");
+        }
+    }
+    for (i = 0; i < policyAmount; i++)
+    {
+        runs[i] = (policyRun){&policies[i], &schedules[i], requests, bookings, first, last};
+        // a policy that cannot get a thread runs on this one
+        started[i] = i > 0 && last - first >= SCHEDULE_THREAD_MIN_WORK && pthread_create(&threads[i], NULL, runPolicy, &runs[i]) == 0;
+    }
+    for (i = 0; i < policyAmount; i++)
+    {
+        if (!started[i])
+        {
+            runPolicy(&runs[i]);
+        }
+    }
+    for (i = 0; i < policyAmount; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+    free(requests);
+}
+
+//  -- Counter-offers --
+// the output module looks for alternatives to each rejected booking on the published schedule,
+// which nothing changes while it is read, so the rejected bookings are split between threads
+
+// kinds of alternative, each rejected booking gets at most one of each
+typedef enum
+{
+    offerSameHours,    // the whole booking at its hours, on the units free now
+    offerMoved,        // the whole booking on the nearest free start of the same day
+    offerFewerDevices, // the booking at its hours, with less devices
+    offerKindAmount,
+} offer_kind;
+
+const char *offerNames[] = {"same hours:", "moved:", "fewer devices:"};
+
+// the maximum number of threads looking for alternatives
+#define OFFER_THREAD_LIMIT 8
+// the least rejected bookings given to a thread
+#define OFFER_THREAD_MIN_WORK 256
+// rejected bookings whose alternatives are held at once, the report is written chunk by chunk
+#define OFFER_CHUNK (OFFER_THREAD_LIMIT * OFFER_THREAD_MIN_WORK)
+
+typedef struct counterOffer
+{
+    booking b;
+    // accepted is 0 if there is no alternative of this kind
+    assignment a;
+} counterOffer;
+
+// the booking moved by shift hours with the devices in keepDevice (bit n for device n),
+// return 1 and fill offer if the schedule has free units for it
+int offerAt(const policySchedule *s, const booking *b, int shift, unsigned int keepDevice, counterOffer *offer)
+{
+    booking c = *b;
+    request r;
+    int n, units[screenResource + 1];
+    c.startMinute += shift * 60;
+    c.deviceCount = 0;
+    for (n = 0; n < b->deviceCount; n++)
+    {
+        if (keepDevice & (1u << n))
+        {
+            c.device[c.deviceCount++] = b->device[n];
+        }
+    }
+    if (!decodeRequest(&c, &r) || !selectBundle(s, &r, 0, units))
+    {
+        return 0;
+    }
+    offer->b = c;
+    assignBooking(&offer->a, &c, units);
+    return 1;
+}
+
+// the alternatives of one rejected booking, offers[kind]
+void findOffers(const policySchedule *s, const booking *b, counterOffer *offers)
+{
+    unsigned int allDevices = (1u << b->deviceCount) - 1;
+    int kind, shift, hour = b->startMinute / 60;
+    for (kind = 0; kind < offerKindAmount; kind++)
+    {
+        offers[kind].a.accepted = 0;
+    }
+    if (offerAt(s, b, 0, allDevices, &offers[offerSameHours]))
+    {
+        return;
+    }
+    // the nearest start first, earlier before later
+    for (shift = 1; shift < DAY_HOURS && !offers[offerMoved].a.accepted; shift++)
+    {
+        if (hour - shift >= 0 && offerAt(s, b, -shift, allDevices, &offers[offerMoved]))
+        {
+            break;
+        }
+        if (hour + shift < DAY_HOURS)
+        {
+            offerAt(s, b, shift, allDevices, &offers[offerMoved]);
+        }
+    }
+    // a room without its devices, a room takes its devices as one pair and a bookDevice has one device
+    if (b->type != bookDevice && b->deviceCount > 0)
+    {
+        offerAt(s, b, 0, 0, &offers[offerFewerDevices]);
+    }
+}
+
+// the rejected bookings [first, last) of ids for one thread
+typedef struct offerRun
+{
+    const policySchedule *schedule;
+    const booking *history;
+    const int *ids;
+    counterOffer *offers;
+    int first;
+    int last;
+} offerRun;
+
+void *runOffers(void *arg)
+{
+    const offerRun *run = arg;
+    int i;
+    for (i = run->first; i < run->last; i++)
+    {
+        findOffers(run->schedule, &run->history[run->ids[i]], &run->offers[i * offerKindAmount]);
+    }
+    return NULL;
+}
+
+// the alternatives of the bookings ids, offerKindAmount of them per booking
+// a part that cannot get a thread runs on this one
+void counterOffers(const policySchedule *s, const booking *history, const int *ids, int count, counterOffer *offers)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = count / OFFER_THREAD_MIN_WORK + 1, i;
+    if (threadCount > online)
+    {
+        threadCount = online > 1 ? online : 1;
+    }
+    if (threadCount > OFFER_THREAD_LIMIT)
+    {
+        threadCount = OFFER_THREAD_LIMIT;
+    }
+    offerRun runs[OFFER_THREAD_LIMIT];
+    pthread_t threads[OFFER_THREAD_LIMIT];
+    int started[OFFER_THREAD_LIMIT];
+    for (i = 0; i < threadCount; i++)
+    {
+        runs[i] = (offerRun){s, history, ids, offers, (long long)count * i / threadCount, (long long)count * (i + 1) / threadCount};
+        started[i] = i > 0 && pthread_create(&threads[i], NULL, runOffers, &runs[i]) == 0;
+    }
+    for (i = 0; i < threadCount; i++)
+    {
+        if (!started[i])
+        {
+            runOffers(&runs[i]);
+        }
+    }
+    for (i = 0; i < threadCount; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+}
+
+//  -- Report writer --
+// reports are formatted into one reusable buffer, written to the file with write() each time it fills up,
+// so a report of any size is streamed with the same memory, in big writes and without stdio locking
+
+// size of the report buffer
+#define REPORT_BUFFER_SIZE (1 << 20)
+// the longest piece written at once, a booking line or a printf
+#define REPORT_LINE_LIMIT 512
+
+typedef struct reportWriter
+{
+    int fd;
+    // kept between reports
+    char *buf;
+    size_t used;
+    // set when a write failed, the rest of the report is dropped
+    int failed;
+} reportWriter;
+
+// start a report in a new file, return 0 if it cannot be created
+int reportOpen(reportWriter *w, const char *fileName)
+{
+    if (w->buf == NULL && (w->buf = malloc(REPORT_BUFFER_SIZE)) == NULL)
+    {
+        return 0;
+    }
+    w->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    w->used = 0;
+    w->failed = 0;
+    return w->fd >= 0;
+}
+
+void reportFlush(reportWriter *w)
+{
+    size_t done = 0;
+    while (!w->failed && done < w->used)
+    {
+        ssize_t n = write(w->fd, w->buf + done, w->used - done);
+        if (n <= 0)
+        {
+            w->failed = 1;
+            break;
+        }
+        done += n;
+    }
+    w->used = 0;
+}
+
+// room for n bytes at the end of the buffer, n is at most REPORT_LINE_LIMIT
+char *reportReserve(reportWriter *w, size_t n)
+{
+    if (w->used + n > REPORT_BUFFER_SIZE)
+    {
+        reportFlush(w);
+    }
+    return w->buf + w->used;
+}
+
+void reportString(reportWriter *w, const char *str)
+{
+    size_t length = strlen(str);
+    while (length > 0)
+    {
+        size_t part = length > REPORT_LINE_LIMIT ? REPORT_LINE_LIMIT : length;
+        memcpy(reportReserve(w, part), str, part);
+        w->used += part;
+        str += part;
+        length -= part;
+    }
+}
+
+void reportPrintf(reportWriter *w, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(reportReserve(w, REPORT_LINE_LIMIT), REPORT_LINE_LIMIT, format, args);
+    va_end(args);
+    if (n > 0)
+    {
+        w->used += n < REPORT_LINE_LIMIT ? n : REPORT_LINE_LIMIT - 1;
+    }
+}
+
+// flush and close the file, the buffer is kept for the next report
+// return 0 if the report could not be written completely
+int reportClose(reportWriter *w)
+{
+    reportFlush(w);
+    if (close(w->fd) != 0)
+    {
+        w->failed = 1;
+    }
+    w->fd = -1;
+    return !w->failed;
+}
+
+// append str, padded with spaces to width
+char *formatPadded(char *out, const char *str, int width)
+{
+    while (*str)
+    {
+        *out++ = *str++;
+        width--;
+    }
+    while (width-- > 0)
+    {
+        *out++ = ' ';
+    }
+    return out;
+}
+
+// append value with two digits
+char *formatTwoDigits(char *out, int value, char pad)
+{
+    *out++ = value >= 10 ? '0' + value / 10 : pad;
+    *out++ = '0' + value % 10;
+    return out;
+}
+
+//  -- Report functions --
+// write one booking of the report, a is NULL in the rejected list (no room column)
+// the line is formatted by hand, it is the bulk of a report
+void printBookingLine(reportWriter *w, const booking *b, const assignment *a)
+{
+    char *out = reportReserve(w, REPORT_LINE_LIMIT);
+    char *line = out;
+    int year, month, day, i;
+    int end = b->startMinute + b->duration;
+
+    // date, start and end: "%04d-%02d-%02d  %02d:%02d  %2d:%02d"
+    civilFromDays(b->day, &year, &month, &day);
+    out = formatTwoDigits(out, year / 100, '0');
+    out = formatTwoDigits(out, year % 100, '0');
+    *out++ = '-';
+    out = formatTwoDigits(out, month, '0');
+    *out++ = '-';
+    out = formatTwoDigits(out, day, '0');
+    out = formatPadded(out, "", 2);
+    out = formatTwoDigits(out, b->startMinute / 60, '0');
+    *out++ = ':';
+    out = formatTwoDigits(out, b->startMinute % 60, '0');
+    out = formatPadded(out, "", 2);
+    out = formatTwoDigits(out, end / 60 % 24, ' ');
+    *out++ = ':';
+    out = formatTwoDigits(out, end % 60, '0');
+    out = formatPadded(out, end >= DAY_HOURS * 60 ? "(the next day)" : "", 16);
+    out = formatPadded(out, b->type == bookDevice ? "*" : eventNames[b->type] + 3, 13);
+    if (a != NULL)
+    {
+        out = formatPadded(out, a->room < 0 ? "*" : resourceName(roomResourceStart + a->room), 9);
+    }
+    for (i = 0; i < b->deviceCount; i++)
+    {
+        out = formatPadded(out, resourceName(a != NULL ? a->device[i] : b->device[i]), 0);
+        *out++ = ' ';
+    }
+    *out++ = '\n';
+    w->used += out - line;
+}
+
+// order the bookings by tenant with a counting sort, keeping their order inside a tenant
+// ids is the list of booking ids to sort, NULL for all the ids below count
+// the bookings of tenant t are order[first[t]] to order[first[t + 1] - 1]
+void orderByTenant(const booking *history, const int *ids, int count, int *order, int *first)
+{
+    int i, t;
+    memset(first, 0, (tenantAmount + 1) * sizeof(int));
+    for (i = 0; i < count; i++)
+    {
+        first[history[ids != NULL ? ids[i] : i].tenant + 1]++;
+    }
+    for (t = 0; t < tenantAmount; t++)
+    {
+        first[t + 1] += first[t];
+    }
+    for (i = 0; i < count; i++)
+    {
+        int id = ids != NULL ? ids[i] : i;
+        order[first[history[id].tenant]++] = id;
+    }
+    // placing moved each start to the next tenant
+    for (t = tenantAmount; t > 0; t--)
+    {
+        first[t] = first[t - 1];
+    }
+    first[0] = 0;
+}
+
+// write the accepted and rejected bookings of one schedule, grouped by tenant
+// accepted bookings are in arrival order, rejected ones in the order they were rejected with their alternatives
+void printSchedule(reportWriter *w, const char *name, const policySchedule *s, const booking *history, int numOfCommand)
+{
+    int i, u, kind;
+    int first[tenantAmount + 1];
+    const assignment *assigned = s->assigned;
+    int *order = malloc((numOfCommand + 1) * sizeof(int));
+    counterOffer *offers = malloc(OFFER_CHUNK * offerKindAmount * sizeof(counterOffer));
+    if (order == NULL || offers == NULL)
+    {
+        printf("Output module Error, out of memory\n");
+        free(order);
+        free(offers);
+        return;
+    }
+
+    // print all accepted bookings
+    orderByTenant(history, NULL, numOfCommand, order, first);
+    reportPrintf(w, "*** Room Booking - ACCEPTED / %s ***\n", name);
+    for (i = 0; i < tenantAmount; i++)
+    {
+        reportPrintf(w, "%s has the following bookings:\n", catalog.tenantNames[i]);
+        reportString(w, "Date        Start  End                  Type         Room     Device           \n");
+        reportString(w, "=================================================================\n");
+        for (u = first[i]; u < first[i + 1]; u++)
+        {
+            if (assigned[order[u]].accepted)
+            {
+                printBookingLine(w, &history[order[u]], &assigned[order[u]]);
+            }
+        }
+        reportString(w, "\n");
+    }
+    reportString(w, "\n");
+
+    // print all rejected command
+    orderByTenant(history, s->rejectedCommandIndex, s->rejectedCount, order, first);
+    reportPrintf(w, "*** Room Booking - REJECTED / %s ***\n", name);
+    for (i = 0; i < tenantAmount; i++)
+    {
+        reportPrintf(w, "%s has the following bookings:\n", catalog.tenantNames[i]);
+        reportString(w, "Date        Start  End                  Type         Device           \n");
+        reportString(w, "=================================================================\n");
+        for (u = first[i]; u < first[i + 1]; u++)
+        {
+            // the alternatives of the next chunk of the rejected list, across tenants
+            if (u % OFFER_CHUNK == 0)
+            {
+                int chunk = s->rejectedCount - u < OFFER_CHUNK ? s->rejectedCount - u : OFFER_CHUNK;
+                counterOffers(s, history, order + u, chunk, offers);
+            }
+            printBookingLine(w, &history[order[u]], NULL);
+            for (kind = 0; kind < offerKindAmount; kind++)
+            {
+                const counterOffer *offer = &offers[u % OFFER_CHUNK * offerKindAmount + kind];
+                if (offer->a.accepted)
+                {
+                    reportPrintf(w, "    %-15s ", offerNames[kind]);
+                    printBookingLine(w, &offer->b, &offer->a);
+                }
+            }
+        }
+        reportString(w, "\n");
+    }
+    free(order);
+    free(offers);
+}
+
+//  -- Utilization --
+// the analyzer turns each resource into day words and counts the booked hours with popcount,
+// so the cost is one word per resource-day whatever the number of bookings
+
+// booked hours of one schedule over the days [firstDay, firstDay + days)
+typedef struct utilization
+{
+    int firstDay;
+    int days;
+    // booked hours of all resources on each day, then of each resource in the same allocation
+    long long *dayHours;
+    long long *resourceHours;
+    // booked hours of all resources and days on each hour of the day
+    long long hourHours[DAY_HOURS];
+} utilization;
+
+// count the booked hours of the calendar, return 0 if out of memory
+int utilizationCompute(utilization *u, const calendar *c, int firstDay, int days)
+{
+    int resource, day;
+    unsigned int *dayMask = malloc((days + 1) * sizeof(unsigned int));
+    u->dayHours = calloc(days + 1 + resourceAmount, sizeof(long long));
+    if (dayMask == NULL || u->dayHours == NULL)
+    {
+        free(dayMask);
+        free(u->dayHours);
+        u->dayHours = NULL;
+        return 0;
+    }
+    u->resourceHours = u->dayHours + days + 1;
+    u->firstDay = firstDay;
+    u->days = days;
+    memset(u->hourHours, 0, sizeof(u->hourHours));
+    for (resource = 0; resource < resourceAmount; resource++)
+    {
+        calendarDayMasks(c, resource, firstDay, days, dayMask);
+        u->resourceHours[resource] = 0;
+        for (day = 0; day < days; day++)
+        {
+            unsigned int booked = dayMask[day];
+            int hours = __builtin_popcount(booked);
+            u->resourceHours[resource] += hours;
+            u->dayHours[day] += hours;
+            while (booked)
+            {
+                u->hourHours[__builtin_ctz(booked)]++;
+                booked &= booked - 1;
+            }
+        }
+    }
+    free(dayMask);
+    return 1;
+}
+
+// part of whole in percent, 0 if whole is 0
+float percentOf(long long part, long long whole)
+{
+    return whole == 0 ? 0 : (float)part / whole * 100;
+}
+
+// write the performance of one schedule
+void printAnalysis(reportWriter *w, const char *name, const utilization *u, int numOfCommand, int rejectedAmount, int invalidCommandAmount)
+{
+    int resource, day, hr, year, month, date;
+    int assignedAmount = numOfCommand - rejectedAmount;
+    reportPrintf(w, "  For %s:\n", name);
+    reportPrintf(w, "            Total Number of Booking Received: %d (%0.1f%%)\n", numOfCommand, percentOf(numOfCommand, numOfCommand));
+    reportPrintf(w, "                  Number of Booking Assigned: %d (%0.1f%%)\n", assignedAmount, percentOf(assignedAmount, numOfCommand));
+    reportPrintf(w, "                  Number of Booking Rejected: %d (%0.1f%%)\n\n", rejectedAmount, percentOf(rejectedAmount, numOfCommand));
+    reportString(w, "            Utilization of Time Slot:\n");
+    for (resource = 0; resource < resourceAmount; resource++)
+    {
+        reportPrintf(w, "                  %-15s- %0.1f%%\n", resourceName(resource), percentOf(u->resourceHours[resource], (long long)u->days * DAY_HOURS));
+    }
+    reportString(w, "\n            Utilization by Day:\n");
+    for (day = 0; day < u->days; day++)
+    {
+        civilFromDays(u->firstDay + day, &year, &month, &date);
+        reportPrintf(w, "                  %04d-%02d-%02d     - %0.1f%%\n", year, month, date, percentOf(u->dayHours[day], (long long)resourceAmount * DAY_HOURS));
+    }
+    reportString(w, "\n            Utilization by Hour:\n");
+    for (hr = 0; hr < DAY_HOURS; hr++)
+    {
+        reportPrintf(w, "                  %02d:00          - %0.1f%%\n", hr, percentOf(u->hourHours[hr], (long long)resourceAmount * u->days));
+    }
+    reportPrintf(w, "\n            Invalid request(s) made: %d\n", invalidCommandAmount);
+}
+
+// one line per schedule, to compare the policies side by side
+void printComparison(reportWriter *w, const char **names, const utilization *u, const int *rejectedAmount, const int *received, int scheduleCount)
+{
+    int i, resource;
+    reportString(w, "Comparison:\n\n");
+    reportString(w, "            Policy          Assigned          Rejected          Utilization\n");
+    for (i = 0; i < scheduleCount; i++)
+    {
+        long long bookedHours = 0;
+        int assignedAmount = received[i] - rejectedAmount[i];
+        for (resource = 0; resource < resourceAmount; resource++)
+        {
+            bookedHours += u[i].resourceHours[resource];
+        }
+        reportPrintf(w, "            %-15s %-8d(%5.1f%%)  %-8d(%5.1f%%)  %0.1f%%\n", names[i], assignedAmount, percentOf(assignedAmount, received[i]),
+                     rejectedAmount[i], percentOf(rejectedAmount[i], received[i]), percentOf(bookedHours, (long long)resourceAmount * u[i].days * DAY_HOURS));
+    }
+}
+
+//  -- Module messages --
+// every pipe carries framed messages: a header with the type and the payload length, then the payload
+// several messages are packed into one writev, so a printBookings is a few system calls
+
+typedef enum
+{
+    MSG_PROMPT,      // parent -> input: read the next line
+    MSG_BOOKING,     // new bookings in the store, int {first id, count}
+    MSG_INVALID,     // input -> parent: the line was rejected, the payload can be an int count of lines
+    MSG_BATCH_START, // input -> parent: the addBatch lines follow without PROMPT, until MSG_END
+    MSG_PRINT,       // printBookings, the payload is the unsigned int set of policies, bit i for policies[i]
+    MSG_END_PROGRAM, // input -> parent: endProgram
+    MSG_SUMMARY,     // parent -> analyzer: int array {numOfCommand, invalid, set of policies}
+    MSG_END,         // end of a group of messages, for printBookings the payload is the schedule generation,
+                     // parent -> input in daemon mode: a printBookings is done
+    MSG_PLACED,      // scheduling -> input with -admit: more bookings are placed, the count is in the shared schedules
+    MSG_CLOSE        // whole program is finish
+} messageType;
+
+typedef struct messageHeader
+{
+    int type;
+    int length;
+} messageHeader;
+
+// a message to send, the payload is not copied
+typedef struct message
+{
+    int type;
+    const void *data;
+    int length;
+} message;
+
+// received payload, grows to the largest message and is always zero terminated
+typedef struct messageBuffer
+{
+    char *data;
+    int length;
+    int capacity;
+} messageBuffer;
+
+// the number of messages in one writev (two iovec per message)
+#define MESSAGE_BATCH 512
+
+// write all the iovec, continuing after partial writes
+int writeAll(int fd, struct iovec *iov, int iovCount)
+{
+    while (iovCount > 0)
+    {
+        ssize_t n = writev(fd, iov, iovCount);
+        if (n < 0)
+        {
+            return -1;
+        }
+        while (iovCount > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            iovCount--;
+        }
+        if (iovCount > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return 0;
+}
+
+int sendMessages(int fd, const message *messages, int count)
+{
+    messageHeader headers[MESSAGE_BATCH];
+    struct iovec iov[MESSAGE_BATCH * 2];
+    int i;
+    while (count > 0)
+    {
+        int batch = count > MESSAGE_BATCH ? MESSAGE_BATCH : count;
+        int iovCount = 0;
+        for (i = 0; i < batch; i++)
+        {
+            headers[i].type = messages[i].type;
+            headers[i].length = messages[i].length;
+            iov[iovCount].iov_base = &headers[i];
+            iov[iovCount].iov_len = sizeof(messageHeader);
+            iovCount++;
+            if (messages[i].length > 0)
+            {
+                iov[iovCount].iov_base = (void *)messages[i].data;
+                iov[iovCount].iov_len = messages[i].length;
+                iovCount++;
+            }
+        }
+        if (writeAll(fd, iov, iovCount) < 0)
+        {
+            return -1;
+        }
+        messages += batch;
+        count -= batch;
+    }
+    return 0;
+}
+
+int sendMessage(int fd, int type, const void *data, int length)
+{
+    message m = {type, data, length};
+    return sendMessages(fd, &m, 1);
+}
+
+// read exactly [length] bytes, 0 if the pipe is closed before
+int readAll(int fd, void *data, int length)
+{
+    char *p = data;
+    while (length > 0)
+    {
+        ssize_t n = read(fd, p, length);
+        if (n <= 0)
+        {
+            return 0;
+        }
+        p += n;
+        length -= n;
+    }
+    return 1;
+}
+
+// read one message into buf, returns its type, or -1 when the pipe is closed
+int receiveMessage(int fd, messageBuffer *buf)
+{
+    messageHeader header;
+    if (!readAll(fd, &header, sizeof(header)) || header.length < 0)
+    {
+        return -1;
+    }
+    if (header.length + 1 > buf->capacity)
+    {
+        buf->capacity = header.length + 1 > 2 * buf->capacity ? header.length + 1 : 2 * buf->capacity;
+        buf->data = realloc(buf->data, buf->capacity);
+    }
+    if (!readAll(fd, buf->data, header.length))
+    {
+        return -1;
+    }
+    buf->data[header.length] = 0;
+    buf->length = header.length;
+    return header.type;
+}
+
+//  -- Booking log --
+// with -log <file>, every booking the input module accepts is appended to a binary log before it is answered,
+// and the log is replayed into the store at startup, so the bookings outlive endProgram and crashes
+// the log is a header, then frames of bookings in id order: a frame header and the raw booking records,
+// each frame with a CRC-32 of its header and bookings; a frame cut by a crash is dropped at the next start,
+// a damaged frame with whole frames after it is not, the log is then refused
+// the bookings are written and synced once per flush to the parent: per line of stdin,
+// per chunk of a batch file, per round of the daemon event loop
+// a write or sync that fails cuts the log back to the last synced frame and ends the program,
+// the bookings of that flush are never answered, so every booking answered is in the log
+
+#define LOG_MAGIC "RBMLOG1"
+
+typedef struct logFileHeader
+{
+    char magic[8];
+    // the frames are only read back by the same build on the same catalog
+    unsigned int bookingSize;
+    unsigned int catalogChecksum;
+} logFileHeader;
+
+typedef struct logFrameHeader
+{
+    // id of the first booking of the frame, the frames follow each other
+    unsigned int first;
+    unsigned int count;
+    // CRC-32 of first, count and the bookings
+    unsigned int checksum;
+} logFrameHeader;
+
+typedef struct bookingLog
+{
+    // -1 without a log
+    int fd;
+    // 1 if bookings were written since the last sync
+    int unsynced;
+    // 1 once a write or sync failed, nothing is written after it
+    int failed;
+    // length of the log up to the last synced frame
+    off_t synced;
+} bookingLog;
+
+bookingLog commandLog = {-1, 0, 0, 0};
+
+unsigned int crcTable[256];
+
+void crcInit(void)
+{
+    unsigned int i, k;
+    for (i = 0; i < 256; i++)
+    {
+        unsigned int crc = i;
+        for (k = 0; k < 8; k++)
+        {
+            crc = crc & 1 ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+        }
+        crcTable[i] = crc;
+    }
+}
+
+// CRC-32 of the bytes, continuing from crc (0 for the first bytes)
+unsigned int crcUpdate(unsigned int crc, const void *data, size_t length)
+{
+    const unsigned char *p = data;
+    crc = ~crc;
+    while (length-- > 0)
+    {
+        crc = crcTable[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// checksum of the tenants, units and room capacities, the bookings refer to them by index
+unsigned int catalogChecksum(void)
+{
+    unsigned int crc = 0;
+    int i;
+    for (i = 0; i < tenantAmount; i++)
+    {
+        crc = crcUpdate(crc, catalog.tenantNames[i], strlen(catalog.tenantNames[i]) + 1);
+    }
+    for (i = 0; i < resourceAmount; i++)
+    {
+        crc = crcUpdate(crc, catalog.resourceNames[i], strlen(catalog.resourceNames[i]) + 1);
+    }
+    crc = crcUpdate(crc, catalog.typeStart, sizeof(catalog.typeStart));
+    return crcUpdate(crc, catalog.roomCapacity, roomAmount * sizeof(int));
+}
+
+unsigned int logFrameChecksum(const logFrameHeader *frame, const booking *bookings)
+{
+    unsigned int crc = crcUpdate(0, frame, offsetof(logFrameHeader, checksum));
+    return crcUpdate(crc, bookings, (size_t)frame->count * sizeof(booking));
+}
+
+// 1 if a whole frame with its checksum right starts after the byte [from] of the log
+// a crash only cuts the frame written last, so such a frame means the log was damaged before it
+int logFrameAfter(int fd, off_t from, off_t size)
+{
+    logFrameHeader frame;
+    off_t p;
+    int found = 0;
+    if (size <= from)
+    {
+        return 0;
+    }
+    const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        // cannot tell, the log is not cut on a guess
+        return 1;
+    }
+    // the header, the frame headers and the bookings are whole words, so the frames start at multiples of 4
+    for (p = from + sizeof(unsigned int); !found && p + (off_t)sizeof(frame) <= size; p += sizeof(unsigned int))
+    {
+        memcpy(&frame, data + p, sizeof(frame));
+        if (frame.count == 0 || frame.count > BOOKING_STORE_CAPACITY || frame.first > BOOKING_STORE_CAPACITY - frame.count ||
+            p + (off_t)sizeof(frame) + (off_t)frame.count * (off_t)sizeof(booking) > size)
+        {
+            continue;
+        }
+        unsigned int crc = crcUpdate(0, &frame, offsetof(logFrameHeader, checksum));
+        found = crcUpdate(crc, data + p + sizeof(frame), (size_t)frame.count * sizeof(booking)) == frame.checksum;
+    }
+    munmap((void *)data, size);
+    return found;
+}
+
+// open or create the log and replay its bookings after the first [skip] into the store,
+// the frames of the first [skip] bookings are stepped over, they are in the store from the snapshot
+// return NULL if opened, with the number of bookings in *numOfBooking, otherwise the error message
+const char *logOpen(bookingLog *log, const char *fileName, booking *bookings, int skip, int *numOfBooking)
+{
+    logFileHeader header, expected;
+    logFrameHeader frame;
+    struct stat fileStat;
+    memset(&expected, 0, sizeof(expected));
+    memcpy(expected.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    expected.bookingSize = sizeof(booking);
+    expected.catalogChecksum = catalogChecksum();
+    *numOfBooking = 0;
+    log->fd = open(fileName, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (log->fd < 0)
+    {
+        return "cannot open the booking log";
+    }
+    if (fstat(log->fd, &fileStat) < 0)
+    {
+        return "cannot open the booking log";
+    }
+    if (!readAll(log->fd, &header, sizeof(header)))
+    {
+        if (skip > 0)
+        {
+            return "the booking log is shorter than its snapshot";
+        }
+        // a new log, or one cut before its header was written
+        struct iovec iov = {&expected, sizeof(expected)};
+        if (ftruncate(log->fd, 0) < 0 || writeAll(log->fd, &iov, 1) < 0 || fsync(log->fd) < 0)
+        {
+            return "cannot write the booking log";
+        }
+        log->synced = sizeof(expected);
+        return NULL;
+    }
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.bookingSize != expected.bookingSize)
+    {
+        return "the booking log is not a log of this program";
+    }
+    if (header.catalogChecksum != expected.catalogChecksum)
+    {
+        return "the booking log was written with another catalog";
+    }
+    // the frames up to the first one that is cut or damaged
+    off_t valid = sizeof(header);
+    while (readAll(log->fd, &frame, sizeof(frame)))
+    {
+        off_t frameSize = sizeof(frame) + (off_t)frame.count * sizeof(booking);
+        if (frame.first == (unsigned int)*numOfBooking && frame.count > 0 && frame.first + frame.count <= (unsigned int)skip && valid + frameSize <= fileStat.st_size)
+        {
+            lseek(log->fd, frame.count * sizeof(booking), SEEK_CUR);
+            *numOfBooking += frame.count;
+            valid += frameSize;
+            continue;
+        }
+        if (frame.first != (unsigned int)*numOfBooking || frame.count == 0 || frame.count > (unsigned int)(BOOKING_STORE_CAPACITY - *numOfBooking) ||
+            !readAll(log->fd, &bookings[frame.first], frame.count * sizeof(booking)) || logFrameChecksum(&frame, &bookings[frame.first]) != frame.checksum)
+        {
+            break;
+        }
+        *numOfBooking += frame.count;
+        valid += frameSize;
+    }
+    if (*numOfBooking < skip)
+    {
+        return "the booking log is shorter than its snapshot";
+    }
+    // the rest is a frame the crash cut, the new frames follow the last whole one
+    off_t end = lseek(log->fd, 0, SEEK_END);
+    if (valid < end && logFrameAfter(log->fd, valid, end))
+    {
+        return "the booking log is damaged";
+    }
+    if (valid < end)
+    {
+        printf("Booking log: %lld bytes after the last whole frame are dropped\n", (long long)(end - valid));
+        if (ftruncate(log->fd, valid) < 0)
+        {
+            return "cannot write the booking log";
+        }
+        end = valid;
+    }
+    log->synced = end;
+    return NULL;
+}
+
+// a write or sync failed: cut the frames after the last synced one and write nothing more,
+// a frame half written would be damage in the middle of the log once others followed it
+void logFail(bookingLog *log)
+{
+    if (ftruncate(log->fd, log->synced) < 0)
+    {
+        printf("Input Module Error: cannot cut the booking log back to its last synced frame\n");
+    }
+    log->failed = 1;
+}
+
+// append the bookings [first, first + count) of the store, they are durable after logSync
+// return 0 if they cannot be written
+int logAppend(bookingLog *log, const booking *bookings, int first, int count)
+{
+    if (log->fd < 0 || count <= 0)
+    {
+        return 1;
+    }
+    if (log->failed)
+    {
+        return 0;
+    }
+    logFrameHeader frame = {first, count, 0};
+    frame.checksum = logFrameChecksum(&frame, &bookings[first]);
+    struct iovec iov[2] = {{&frame, sizeof(frame)}, {(void *)&bookings[first], count * sizeof(booking)}};
+    if (writeAll(log->fd, iov, 2) < 0)
+    {
+        logFail(log);
+        return 0;
+    }
+    log->unsynced = 1;
+    return 1;
+}
+
+// make the bookings appended so far durable, one sync for the whole group
+// return 0 if they cannot be, a failed sync leaves the pages in an unknown state so the log is not used again
+int logSync(bookingLog *log)
+{
+    if (log->fd < 0 || !log->unsynced)
+    {
+        return !log->failed;
+    }
+    if (fdatasync(log->fd) < 0)
+    {
+        logFail(log);
+        return 0;
+    }
+    log->synced = lseek(log->fd, 0, SEEK_END);
+    log->unsynced = 0;
+    return 1;
+}
+
+//  -- Schedule snapshots --
+// with -log <file>, the scheduling module also writes the schedules and the booking store to <file>.snapshot,
+// every SNAPSHOT_INTERVAL bookings and at endProgram, so a restart only places the bookings of the log after it
+// the calendars link their nodes by index, so the snapshot is the arrays as they are, at offsets from the
+// start of the file: a start maps it and copies the arrays back into the shared regions
+// a snapshot is written to a temporary file and renamed over the last one, so it is never seen half written,
+// and it is only copied back if its checksums match and every index in it is in range, otherwise the log is replayed
+
+#define SNAPSHOT_MAGIC "RBMSNAP2"
+// bookings placed between two snapshots
+#define SNAPSHOT_INTERVAL (1 << 18)
+// alignment of the arrays in the file
+#define SNAPSHOT_ALIGN 64
+
+typedef struct snapshotPolicy
+{
+    int nodeCount;
+    int freeNode;
+    int rejectedCount;
+    int withdrawn;
+    // from the start of the file
+    long long rootOffset;
+    long long nodeOffset;
+    long long heldByOffset;
+    long long rejectedOffset;
+    long long assignedOffset;
+} snapshotPolicy;
+
+typedef struct snapshotHeader
+{
+    char magic[8];
+    // a snapshot is only read back by the same build on the same catalog
+    unsigned int catalogChecksum;
+    unsigned int bookingSize;
+    unsigned int nodeSize;
+    unsigned int assignmentSize;
+    // units of the catalog and schedules of the policies
+    int units;
+    int scheduleCount;
+    // the bookings [0, numOfBooking) are in the store and placed on every schedule
+    int numOfBooking;
+    int reserved;
+    long long bookingOffset;
+    long long fileSize;
+    snapshotPolicy policy[POLICY_LIMIT];
+    // CRC-32 of the file after the header
+    unsigned int bodyChecksum;
+    // CRC-32 of the header before it
+    unsigned int checksum;
+} snapshotHeader;
+
+// file of the snapshot of the log, NULL without a log
+char *snapshotFile = NULL;
+
+// add an array to the file layout, return its offset
+long long snapshotPlace(struct iovec *iov, int *iovCount, long long *size, const void *data, size_t length)
+{
+    static const char padding[SNAPSHOT_ALIGN] = {0};
+    long long offset = (*size + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+    if (offset > *size)
+    {
+        iov[(*iovCount)++] = (struct iovec){(void *)padding, offset - *size};
+    }
+    if (length > 0)
+    {
+        iov[(*iovCount)++] = (struct iovec){(void *)data, length};
+    }
+    *size = offset + length;
+    return offset;
+}
+
+// write the schedules and the bookings [0, numOfBooking), return 0 if the snapshot cannot be written
+// the rejected lists are written as they are, compactRejected is called before so they have no stale entries
+int snapshotWrite(const char *fileName, const sharedSchedule *shared, const booking *bookings, int numOfBooking)
+{
+    snapshotHeader header;
+    struct iovec iov[2 + 2 * (1 + 5 * POLICY_LIMIT)];
+    int iovCount = 0, i;
+    long long size = 0;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.catalogChecksum = catalogChecksum();
+    header.bookingSize = sizeof(booking);
+    header.nodeSize = sizeof(intervalNode);
+    header.assignmentSize = sizeof(assignment);
+    header.units = resourceAmount;
+    header.scheduleCount = policyAmount;
+    header.numOfBooking = numOfBooking;
+    snapshotPlace(iov, &iovCount, &size, &header, sizeof(header));
+    header.bookingOffset = snapshotPlace(iov, &iovCount, &size, bookings, (size_t)numOfBooking * sizeof(booking));
+    for (i = 0; i < policyAmount; i++)
+    {
+        const policySchedule *s = &shared->schedules[i];
+        snapshotPolicy *p = &header.policy[i];
+        p->nodeCount = s->cal.nodeCount;
+        p->freeNode = s->cal.freeNode;
+        p->rejectedCount = s->rejectedCount;
+        p->withdrawn = s->withdrawn;
+        p->rootOffset = snapshotPlace(iov, &iovCount, &size, s->cal.root, resourceAmount * sizeof(int));
+        // node 0 is never used, it is kept so the indexes stay the same
+        p->nodeOffset = snapshotPlace(iov, &iovCount, &size, s->cal.nodes, (size_t)(s->cal.nodeCount + 1) * sizeof(intervalNode));
+        p->heldByOffset = snapshotPlace(iov, &iovCount, &size, s->cal.heldBy, (size_t)numOfBooking * sizeof(int));
+        p->rejectedOffset = snapshotPlace(iov, &iovCount, &size, s->rejectedCommandIndex, (size_t)s->rejectedCount * sizeof(int));
+        p->assignedOffset = snapshotPlace(iov, &iovCount, &size, s->assigned, (size_t)numOfBooking * sizeof(assignment));
+    }
+    header.fileSize = size;
+    for (i = 1; i < iovCount; i++)
+    {
+        header.bodyChecksum = crcUpdate(header.bodyChecksum, iov[i].iov_base, iov[i].iov_len);
+    }
+    header.checksum = crcUpdate(0, &header, offsetof(snapshotHeader, checksum));
+
+    char temporary[4096];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", fileName);
+    int file = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0)
+    {
+        return 0;
+    }
+    if (writeAll(file, iov, iovCount) < 0 || fsync(file) < 0)
+    {
+        close(file);
+        unlink(temporary);
+        return 0;
+    }
+    close(file);
+    return rename(temporary, fileName) == 0;
+}
+
+// 1 if the array [offset, offset + length) is inside the file
+int snapshotHas(const snapshotHeader *header, long long offset, long long length)
+{
+    return offset >= (long long)sizeof(snapshotHeader) && length >= 0 && offset + length <= header->fileSize;
+}
+
+// 1 if every index in the arrays of the snapshot is in range, the calendars follow them without checks
+int snapshotInRange(const snapshotHeader *header, const char *data)
+{
+    const booking *bookings = (const booking *)(data + header->bookingOffset);
+    int n = header->numOfBooking, i, k, c;
+    for (c = 0; c < n; c++)
+    {
+        const booking *b = &bookings[c];
+        if (b->type > cancelBooking || b->deviceCount > MAX_BOOKING_DEVICE || b->tenant >= tenantAmount || b->target < 0 || b->target > c)
+        {
+            return 0;
+        }
+        for (k = 0; k < b->deviceCount; k++)
+        {
+            if (b->device[k] >= resourceAmount)
+            {
+                return 0;
+            }
+        }
+    }
+    for (i = 0; i < policyAmount; i++)
+    {
+        const snapshotPolicy *p = &header->policy[i];
+        const int *root = (const int *)(data + p->rootOffset);
+        const intervalNode *nodes = (const intervalNode *)(data + p->nodeOffset);
+        const int *heldBy = (const int *)(data + p->heldByOffset);
+        const int *rejected = (const int *)(data + p->rejectedOffset);
+        const assignment *assigned = (const assignment *)(data + p->assignedOffset);
+        for (k = 0; k < resourceAmount; k++)
+        {
+            if (root[k] < 0 || root[k] > p->nodeCount)
+            {
+                return 0;
+            }
+        }
+        for (k = 1; k <= p->nodeCount; k++)
+        {
+            const intervalNode *node = &nodes[k];
+            if (node->left < 0 || node->left > p->nodeCount || node->right < 0 || node->right > p->nodeCount || node->nextHeld < 0 || node->nextHeld > p->nodeCount ||
+                node->command < -1 || node->command >= n || (node->command >= 0 && (node->resource < 0 || node->resource >= resourceAmount)))
+            {
+                return 0;
+            }
+        }
+        for (k = 0; k < p->rejectedCount; k++)
+        {
+            if (rejected[k] < 0 || rejected[k] >= n)
+            {
+                return 0;
+            }
+        }
+        for (c = 0; c < n; c++)
+        {
+            const assignment *a = &assigned[c];
+            if (heldBy[c] < 0 || heldBy[c] > p->nodeCount || a->room < -1 || a->room >= roomAmount || (a->accepted != 0 && a->accepted != 1) ||
+                a->evictedBy < -1 || a->evictedBy >= n || a->rejectedAt < -1 || a->rejectedAt >= p->rejectedCount || a->displaced < -1 || a->displaced >= n ||
+                a->nextDisplaced < -1 || a->nextDisplaced >= n || a->current < -1 || a->current >= n)
+            {
+                return 0;
+            }
+            for (k = 0; k < MAX_BOOKING_DEVICE; k++)
+            {
+                if (a->device[k] < -1 || a->device[k] >= resourceAmount)
+                {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+// copy the snapshot into the schedules and the store, nothing is copied if there is no snapshot
+// return NULL if copied or missing, with the number of bookings in it in *numOfBooking, otherwise the error message
+const char *snapshotLoad(const char *fileName, sharedSchedule *shared, booking *bookings, int *numOfBooking)
+{
+    struct stat fileStat;
+    const snapshotHeader *header;
+    int i;
+    *numOfBooking = 0;
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+    {
+        return NULL;
+    }
+    if (fstat(file, &fileStat) < 0 || fileStat.st_size < (off_t)sizeof(snapshotHeader))
+    {
+        close(file);
+        return "the snapshot is damaged";
+    }
+    const char *data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        return "cannot map the snapshot";
+    }
+    madvise((void *)data, fileStat.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+    header = (const snapshotHeader *)data;
+    const char *error = NULL;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->checksum != crcUpdate(0, header, offsetof(snapshotHeader, checksum)) ||
+        header->fileSize != fileStat.st_size)
+    {
+        error = "the snapshot is damaged";
+    }
+    else if (header->bookingSize != sizeof(booking) || header->nodeSize != sizeof(intervalNode) || header->assignmentSize != sizeof(assignment) ||
+             header->scheduleCount != policyAmount)
+    {
+        error = "the snapshot is not a snapshot of this program";
+    }
+    else if (header->catalogChecksum != catalogChecksum() || header->units != resourceAmount)
+    {
+        error = "the snapshot was written with another catalog";
+    }
+    long long n = header->numOfBooking;
+    if (error == NULL && (n < 0 || n > BOOKING_STORE_CAPACITY || !snapshotHas(header, header->bookingOffset, n * sizeof(booking))))
+    {
+        error = "the snapshot is damaged";
+    }
+    for (i = 0; i < policyAmount && error == NULL; i++)
+    {
+        const snapshotPolicy *p = &header->policy[i];
+        if (p->nodeCount < 0 || p->nodeCount >= CALENDAR_NODE_CAPACITY || p->freeNode < 0 || p->freeNode > p->nodeCount || p->rejectedCount < 0 || p->rejectedCount > n || p->withdrawn < 0 || p->withdrawn > n ||
+            !snapshotHas(header, p->rootOffset, resourceAmount * sizeof(int)) || !snapshotHas(header, p->nodeOffset, (p->nodeCount + 1LL) * sizeof(intervalNode)) ||
+            !snapshotHas(header, p->heldByOffset, n * sizeof(int)) || !snapshotHas(header, p->rejectedOffset, p->rejectedCount * (long long)sizeof(int)) ||
+            !snapshotHas(header, p->assignedOffset, n * sizeof(assignment)))
+        {
+            error = "the snapshot is damaged";
+        }
+    }
+    if (error == NULL && (header->bodyChecksum != crcUpdate(0, data + sizeof(snapshotHeader), header->fileSize - sizeof(snapshotHeader)) || !snapshotInRange(header, data)))
+    {
+        error = "the snapshot is damaged";
+    }
+    if (error == NULL)
+    {
+        memcpy(bookings, data + header->bookingOffset, n * sizeof(booking));
+        for (i = 0; i < policyAmount; i++)
+        {
+            const snapshotPolicy *p = &header->policy[i];
+            policySchedule *s = &shared->schedules[i];
+            memcpy(s->cal.root, data + p->rootOffset, resourceAmount * sizeof(int));
+            memcpy(s->cal.nodes, data + p->nodeOffset, (p->nodeCount + 1LL) * sizeof(intervalNode));
+            memcpy(s->cal.heldBy, data + p->heldByOffset, n * sizeof(int));
+            memcpy(s->rejectedCommandIndex, data + p->rejectedOffset, p->rejectedCount * sizeof(int));
+            memcpy(s->assigned, data + p->assignedOffset, n * sizeof(assignment));
+            s->cal.nodeCount = p->nodeCount;
+            s->cal.freeNode = p->freeNode;
+            s->rejectedCount = p->rejectedCount;
+            s->staleCount = 0;
+            s->withdrawn = p->withdrawn;
+        }
+        *numOfBooking = n;
+    }
+    munmap((void *)data, fileStat.st_size);
+    return error;
+}
+
+//  -- Batch loading --
+// addBatch maps the whole file and parses it in one pass,
+// the bookings go to the parent in chunks instead of one PROMPT round trip per line
+
+// the number of bookings in one message, so the scheduling module starts before the whole file is parsed
+#define BATCH_CHUNK 4096
+
+// log the parsed bookings as one group, then send them and the count of invalid lines to the parent
+// return 0 if the log cannot take them, the parent is then told to end the program and they are not answered
+int flushBatch(int fd, const booking *bookings, int *numOfBooking, int *count, int *invalid)
+{
+    message messages[2];
+    int messageCount = 0;
+    int range[2] = {*numOfBooking, *count};
+    if (commandLog.failed)
+    {
+        return 0;
+    }
+    if (*count > 0 && (!logAppend(&commandLog, bookings, *numOfBooking, *count) || !logSync(&commandLog)))
+    {
+        printf("Input Module Error: cannot write the booking log, the last %d bookings are not taken and the program ends\n", *count);
+        fflush(stdout);
+        sendMessage(fd, MSG_END_PROGRAM, NULL, 0);
+        *count = 0;
+        return 0;
+    }
+    if (*invalid > 0)
+    {
+        messages[messageCount++] = (message){MSG_INVALID, invalid, sizeof(int)};
+    }
+    if (*count > 0)
+    {
+        messages[messageCount++] = (message){MSG_BOOKING, range, sizeof(range)};
+    }
+    sendMessages(fd, messages, messageCount);
+    *numOfBooking += *count;
+    *count = 0;
+    *invalid = 0;
+    return 1;
+}
+
+// parse the lines of a batch file into the store after numOfBooking and send them to the parent, in the file order
+// the number of printBookings sent is added to *prints
+// return -1 if the file cannot be read, 1 if the file has endProgram or the log fails, otherwise 0
+int loadBatch(const char *fileName, int fd, booking *bookings, int *numOfBooking, int *prints)
+{
+    struct stat fileStat;
+    const char *data = NULL;
+    int file = open(fileName, O_RDONLY);
+    if (file < 0)
+    {
+        return -1;
+    }
+    if (fstat(file, &fileStat) < 0)
+    {
+        close(file);
+        return -1;
+    }
+    if (fileStat.st_size > 0)
+    {
+        data = mmap(NULL, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED)
+        {
+            close(file);
+            return -1;
+        }
+        madvise((void *)data, fileStat.st_size, MADV_SEQUENTIAL);
+    }
+    close(file);
+
+    char line[COMMAND_CHAR_SIZE];
+    char *words[COMMAND_WORD_LIMIT];
+    int count = 0, invalid = 0, isEnd = 0;
+    const char *p = data;
+    const char *end = data + fileStat.st_size;
+    sendMessage(fd, MSG_BATCH_START, NULL, 0);
+    while (p < end && isEnd == 0)
+    {
+        const char *lineEnd = memchr(p, '\n', end - p);
+        if (lineEnd == NULL)
+        {
+            lineEnd = end;
+        }
+        int length = lineEnd - p;
+        if (length >= COMMAND_CHAR_SIZE)
+        {
+            printf("Input Module Error: line is too long\n");
+            invalid++;
+            p = lineEnd + 1;
+            continue;
+        }
+        memcpy(line, p, length);
+        line[length] = 0;
+        p = lineEnd + 1;
+
+        int wordCount = splitWords(line, words, COMMAND_WORD_LIMIT);
+        if (wordCount == 0)
+        {
+            printf("Input Module Error: entering empty line\n");
+            invalid++;
+            continue;
+        }
+        if (strcmp(words[0], "endProgram") == 0 || strcmp(words[0], "printBookings") == 0)
+        {
+            // control command: the lines before it go first
+            if (!flushBatch(fd, bookings, numOfBooking, &count, &invalid))
+            {
+                isEnd = 1;
+            }
+            else if (words[0][0] == 'e')
+            {
+                sendMessage(fd, MSG_END_PROGRAM, NULL, 0);
+                isEnd = 1;
+            }
+            else
+            {
+                unsigned int policyMask;
+                const char *error = parsePolicies(words, wordCount, &policyMask);
+                if (error != NULL)
+                {
+                    printf("Input Module Error: %s\n", error);
+                    invalid++;
+                }
+                else
+                {
+                    sendMessage(fd, MSG_PRINT, &policyMask, sizeof(policyMask));
+                    (*prints)++;
+                }
+            }
+            continue;
+        }
+        if (strcmp(words[0], "addBatch") == 0)
+        {
+            printf("Input Module Error: addBatch inside a batch file\n");
+            invalid++;
+            continue;
+        }
+        if (*numOfBooking + count >= BOOKING_STORE_CAPACITY)
+        {
+            printf("Input Module Error: booking store is full\n");
+            invalid++;
+            continue;
+        }
+        const char *error = parseEntry(words, wordCount, bookings, *numOfBooking + count);
+        if (error != NULL)
+        {
+            printf("Input Module Error: %s\n", error);
+            invalid++;
+            continue;
+        }
+        if (++count == BATCH_CHUNK && !flushBatch(fd, bookings, numOfBooking, &count, &invalid))
+        {
+            isEnd = 1;
+        }
+    }
+    if (isEnd == 0)
+    {
+        if (flushBatch(fd, bookings, numOfBooking, &count, &invalid))
+        {
+            sendMessage(fd, MSG_END, NULL, 0);
+        }
+        else
+        {
+            isEnd = 1;
+        }
+    }
+    if (data != NULL)
+    {
+        munmap((void *)data, fileStat.st_size);
+    }
+    return isEnd;
+}
+
+//  -- Online admission --
+// with -admit, each booking is answered once it is on the live FCFS schedule instead of with [Pending]
+// the scheduling module raises the placed count of the shared schedules and rings the input module on a pipe,
+// the count is what tells which bookings are placed, a ring lost on a full pipe is never needed
+// FCFS never moves a booking it has placed, so the answer stays true until the booking is cancelled or moved,
+// and a reply read after that still tells the decision, a withdrawn booking keeps the units it was given
+
+// the schedule the answers come from, FCFS in policies
+#define ADMISSION_POLICY 0
+
+// the number of bookings placed on every schedule
+int admissionPlaced(const sharedSchedule *shared)
+{
+    return __atomic_load_n(&shared->placed, __ATOMIC_ACQUIRE);
+}
+
+// the reply to booking id once it is placed, the room and the units it got, or its rejection
+void admissionReply(const sharedSchedule *shared, const booking *bookings, int id, char *reply, int size)
+{
+    const assignment *a = &shared->schedules[ADMISSION_POLICY].assigned[id];
+    const booking *b = &bookings[id];
+    int i, length;
+    if (b->type == cancelBooking)
+    {
+        snprintf(reply, size, "-> [Cancelled: booking %d]\n", b->target);
+        return;
+    }
+    // withdrawn since it was placed, accepted if it was given a room or a device
+    int accepted = a->accepted || (a->rejectedAt < 0 && (a->room >= 0 || a->device[0] >= 0));
+    if (!accepted)
+    {
+        snprintf(reply, size, "-> [Rejected: booking %d]\n", id + 1);
+        return;
+    }
+    length = snprintf(reply, size, "-> [Accepted: booking %d", id + 1);
+    if (a->room >= 0)
+    {
+        length += snprintf(reply + length, size - length, " in %s", resourceName(roomResourceStart + a->room));
+    }
+    for (i = 0; i < b->deviceCount; i++)
+    {
+        length += snprintf(reply + length, size - length, "%s %s", i == 0 ? " with" : "", resourceName(a->device[i]));
+    }
+    snprintf(reply + length, size - length, "]\n");
+}
+
+//  -- Booking daemon --
+// with -daemon <socket path>, the input module serves local clients on a unix domain socket instead of stdin
+// each line of a client is a command of the usual grammar and gets one reply line, in the order of its commands,
+// so a client can send many commands without waiting for the replies
+// one epoll loop serves every client, the bookings they send in one round go to the parent as one range
+
+// the bytes of commands read ahead on one connection
+#define DAEMON_INPUT_BUFFER 4096
+// a connection is not read while it has this many reply bytes not sent
+#define DAEMON_OUTPUT_LIMIT (1 << 16)
+// the events handled in one round of the event loop
+#define DAEMON_EVENT_BATCH 64
+
+typedef struct daemonConnection
+{
+    int fd;
+    // commands read and not handled yet, one more byte to end the last line
+    char in[DAEMON_INPUT_BUFFER + 1];
+    int inLength;
+    // 1 while the rest of a line too long for the buffer is skipped
+    int skipping;
+    // replies, the bytes [outSent, outLength) are not sent yet
+    char *out;
+    int outLength;
+    int outSent;
+    int outCapacity;
+    // printBookings sent to the parent and not finished, the next commands of the connection wait for them
+    int waiting;
+    // reply of the command waiting
+    char deferred[64];
+    // bookings of the connection not answered yet with -admit, only bookings run before they are
+    int decisions;
+    // 1 once the client has sent everything
+    int eof;
+    // 1 once the socket is closed, the replies are dropped
+    int closed;
+    // 1 once the connection is finished, it is freed at the end of the round
+    int retired;
+    struct daemonConnection *nextRetired;
+    // 1 if the connection has to be settled at the end of the round
+    int touched;
+    struct daemonConnection *nextTouched;
+    // events the socket is watched for
+    unsigned int events;
+} daemonConnection;
+
+// printBookings of one command sent to the parent, count of them not finished yet
+typedef struct daemonPrint
+{
+    daemonConnection *c;
+    int count;
+} daemonPrint;
+
+// a booking answered once the scheduling module has placed it
+typedef struct daemonDecision
+{
+    int id;
+    daemonConnection *c;
+} daemonDecision;
+
+typedef struct daemonServer
+{
+    int epoll;
+    int listener;
+    // pipes from and to the parent
+    int fromParent;
+    int toParent;
+    booking *bookings;
+    // next booking id sent to the parent, the bookings parsed after it and the invalid commands not sent yet
+    int numOfBooking;
+    int count;
+    int invalid;
+    // the connection of each socket, by file descriptor
+    daemonConnection **byFd;
+    int fdCapacity;
+    // printBookings sent to the parent, in the order they were sent
+    daemonPrint *printQueue;
+    int printHead;
+    int printLength;
+    int printCapacity;
+    // with -admit, the pipe rung by the scheduling module and the bookings not answered, in id order
+    int admission;
+    const sharedSchedule *shared;
+    daemonDecision *decisions;
+    int decisionHead;
+    int decisionLength;
+    int decisionCapacity;
+    daemonConnection *retired;
+    // connections with new replies or events this round, settled once the bookings of the round are logged
+    daemonConnection *touched;
+    // 1 after endProgram, the daemon stops once every reply is sent
+    int ending;
+    // 1 once the log failed, the daemon stops without sending the replies it has
+    int logFailed;
+} daemonServer;
+
+// queue a reply to the client
+void daemonReply(daemonConnection *c, const char *text)
+{
+    int length = strlen(text);
+    if (c->closed)
+    {
+        return;
+    }
+    if (c->outLength + length > c->outCapacity)
+    {
+        int capacity = c->outCapacity > 0 ? c->outCapacity : 256;
+        while (c->outLength + length > capacity)
+        {
+            capacity *= 2;
+        }
+        char *out = realloc(c->out, capacity);
+        if (out == NULL)
+        {
+            return;
+        }
+        c->out = out;
+        c->outCapacity = capacity;
+    }
+    memcpy(c->out + c->outLength, text, length);
+    c->outLength += length;
+}
+
+// close the socket, the connection stays until nothing waits on it
+void daemonDrop(daemonServer *d, daemonConnection *c)
+{
+    if (c->closed)
+    {
+        return;
+    }
+    epoll_ctl(d->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    d->byFd[c->fd] = NULL;
+    c->closed = 1;
+    c->outLength = 0;
+    c->outSent = 0;
+}
+
+// an invalid command, counted like the invalid lines of stdin
+void daemonError(daemonServer *d, daemonConnection *c, const char *error)
+{
+    char reply[128];
+    snprintf(reply, sizeof(reply), "Error: %s\n", error);
+    daemonReply(c, reply);
+    d->invalid++;
+}
+
+// send the bookings parsed so far and the invalid count to the parent
+// if the log fails, the daemon stops before it sends any reply of the round
+void daemonFlush(daemonServer *d)
+{
+    if ((d->count > 0 || d->invalid > 0) && !flushBatch(d->toParent, d->bookings, &d->numOfBooking, &d->count, &d->invalid))
+    {
+        d->ending = 1;
+        d->logFailed = 1;
+    }
+}
+
+// make room in the print queue for one more command, before it sends anything to the parent
+// return 0 if there is no memory for it
+int daemonPrintRoom(daemonServer *d)
+{
+    if (d->printLength < d->printCapacity)
+    {
+        return 1;
+    }
+    if (d->printHead > 0)
+    {
+        if (d->printLength > d->printHead)
+        {
+            memmove(d->printQueue, d->printQueue + d->printHead, (d->printLength - d->printHead) * sizeof(daemonPrint));
+        }
+        d->printLength -= d->printHead;
+        d->printHead = 0;
+        return 1;
+    }
+    int capacity = d->printCapacity > 0 ? 2 * d->printCapacity : 64;
+    daemonPrint *queue = realloc(d->printQueue, capacity * sizeof(daemonPrint));
+    if (queue == NULL)
+    {
+        return 0;
+    }
+    d->printQueue = queue;
+    d->printCapacity = capacity;
+    return 1;
+}
+
+// hold the next commands of the connection until the parent has finished [prints] printBookings
+// the room for it is made by daemonPrintRoom
+void daemonWait(daemonServer *d, daemonConnection *c, int prints, const char *reply)
+{
+    if (prints == 0)
+    {
+        daemonReply(c, reply);
+        return;
+    }
+    d->printQueue[d->printLength++] = (daemonPrint){c, prints};
+    c->waiting += prints;
+    snprintf(c->deferred, sizeof(c->deferred), "%s", reply);
+}
+
+// make room for one more booking to answer, before it is sent to the parent
+// return 0 if there is no memory for it
+int daemonDecisionRoom(daemonServer *d)
+{
+    if (d->decisionLength < d->decisionCapacity)
+    {
+        return 1;
+    }
+    if (d->decisionHead > 0)
+    {
+        if (d->decisionLength > d->decisionHead)
+        {
+            memmove(d->decisions, d->decisions + d->decisionHead, (d->decisionLength - d->decisionHead) * sizeof(daemonDecision));
+        }
+        d->decisionLength -= d->decisionHead;
+        d->decisionHead = 0;
+        return 1;
+    }
+    int capacity = d->decisionCapacity > 0 ? 2 * d->decisionCapacity : 256;
+    daemonDecision *decisions = realloc(d->decisions, capacity * sizeof(daemonDecision));
+    if (decisions == NULL)
+    {
+        return 0;
+    }
+    d->decisions = decisions;
+    d->decisionCapacity = capacity;
+    return 1;
+}
+
+// answer booking id once it is placed, the room for it is made by daemonDecisionRoom
+void daemonAdmit(daemonServer *d, daemonConnection *c, int id)
+{
+    d->decisions[d->decisionLength++] = (daemonDecision){id, c};
+    c->decisions++;
+}
+
+// run one command line of a client
+// return 0 if it has to wait for the answers of the bookings before it, the line is then left as it was
+int daemonCommand(daemonServer *d, daemonConnection *c, const char *line)
+{
+    char text[COMMAND_CHAR_SIZE];
+    char *words[COMMAND_WORD_LIMIT];
+    strcpy(text, line);
+    int wordCount = splitWords(text, words, COMMAND_WORD_LIMIT);
+    const char *error;
+    int isBooking = wordCount > 0 && strcmp(words[0], "endProgram") != 0 && strcmp(words[0], "printBookings") != 0 && strcmp(words[0], "addBatch") != 0;
+    if (c->decisions > 0 && !isBooking)
+    {
+        return 0;
+    }
+    if (wordCount == 0)
+    {
+        daemonError(d, c, "entering empty line");
+    }
+    else if (strcmp(words[0], "endProgram") == 0)
+    {
+        daemonFlush(d);
+        if (d->logFailed)
+        {
+            return 1;
+        }
+        sendMessage(d->toParent, MSG_END_PROGRAM, NULL, 0);
+        d->ending = 1;
+        daemonReply(c, "-> Bye!\n");
+    }
+    else if (strcmp(words[0], "printBookings") == 0)
+    {
+        unsigned int policyMask;
+        if ((error = parsePolicies(words, wordCount, &policyMask)) != NULL)
+        {
+            daemonError(d, c, error);
+            return 1;
+        }
+        // a client whose reply cannot be queued would wait for it forever
+        if (!daemonPrintRoom(d))
+        {
+            daemonDrop(d, c);
+            return 1;
+        }
+        // the bookings before it go first
+        daemonFlush(d);
+        if (d->logFailed)
+        {
+            return 1;
+        }
+        sendMessage(d->toParent, MSG_PRINT, &policyMask, sizeof(policyMask));
+        daemonWait(d, c, 1, "-> [Done!]\n");
+    }
+    else if (strcmp(words[0], "addBatch") == 0)
+    {
+        if (wordCount < 2)
+        {
+            daemonError(d, c, "addBatch needs a file");
+            return 1;
+        }
+        if (!daemonPrintRoom(d))
+        {
+            daemonDrop(d, c);
+            return 1;
+        }
+        daemonFlush(d);
+        if (d->logFailed)
+        {
+            return 1;
+        }
+        int first = d->numOfBooking, prints = 0;
+        int result = loadBatch(words[1] + 1, d->toParent, d->bookings, &d->numOfBooking, &prints);
+        if (result < 0)
+        {
+            daemonError(d, c, "cannot open the batch file");
+            return 1;
+        }
+        char reply[64];
+        snprintf(reply, sizeof(reply), result == 1 ? "-> Bye!\n" : "-> [Pending: %d bookings]\n", d->numOfBooking - first);
+        d->ending = result == 1;
+        daemonWait(d, c, prints, reply);
+    }
+    else
+    {
+        int id = d->numOfBooking + d->count;
+        // a client whose answer cannot be queued would wait for it forever
+        if (d->admission >= 0 && !daemonDecisionRoom(d))
+        {
+            daemonDrop(d, c);
+            return 1;
+        }
+        error = id >= BOOKING_STORE_CAPACITY ? "booking store is full" : parseEntry(words, wordCount, d->bookings, id);
+        if (error != NULL && c->decisions > 0)
+        {
+            return 0;
+        }
+        if (error != NULL)
+        {
+            daemonError(d, c, error);
+            return 1;
+        }
+        if (++d->count == BATCH_CHUNK)
+        {
+            daemonFlush(d);
+        }
+        if (d->admission >= 0)
+        {
+            daemonAdmit(d, c, id);
+        }
+        else
+        {
+            daemonReply(c, "-> [Pending]\n");
+        }
+    }
+    return 1;
+}
+
+// run the complete lines read from the client, until one has to wait for the parent
+void daemonProcess(daemonServer *d, daemonConnection *c)
+{
+    int start = 0;
+    while (c->waiting == 0 && !d->ending && !c->closed && start < c->inLength)
+    {
+        char *line = c->in + start;
+        char *lineEnd = memchr(line, '\n', c->inLength - start);
+        if (lineEnd == NULL && !c->eof)
+        {
+            if (start == 0 && c->inLength == DAEMON_INPUT_BUFFER && c->decisions == 0)
+            {
+                // the line does not fit, the rest of it is skipped
+                if (!c->skipping)
+                {
+                    daemonError(d, c, "line is too long");
+                }
+                c->skipping = 1;
+                start = c->inLength;
+            }
+            break;
+        }
+        // the last line of a client can end without a newline
+        int length = lineEnd != NULL ? lineEnd - line : c->inLength - start;
+        start += length + (lineEnd != NULL);
+        if (c->skipping)
+        {
+            c->skipping = 0;
+            continue;
+        }
+        if (length >= COMMAND_CHAR_SIZE && c->decisions == 0)
+        {
+            daemonError(d, c, "line is too long");
+            continue;
+        }
+        if (length < COMMAND_CHAR_SIZE)
+        {
+            line[length] = 0;
+        }
+        if (length >= COMMAND_CHAR_SIZE || !daemonCommand(d, c, line))
+        {
+            // the line is run again once the bookings before it are answered
+            if (lineEnd != NULL)
+            {
+                *lineEnd = '\n';
+            }
+            start = line - c->in;
+            break;
+        }
+    }
+    memmove(c->in, c->in + start, c->inLength - start);
+    c->inLength -= start;
+}
+
+// send the replies the socket takes without blocking
+void daemonSend(daemonServer *d, daemonConnection *c)
+{
+    while (!c->closed && c->outSent < c->outLength)
+    {
+        ssize_t n = send(c->fd, c->out + c->outSent, c->outLength - c->outSent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return;
+        }
+        if (n < 0)
+        {
+            daemonDrop(d, c);
+            return;
+        }
+        c->outSent += n;
+    }
+    c->outSent = 0;
+    c->outLength = 0;
+}
+
+// settle the connection at the end of the round
+void daemonTouch(daemonServer *d, daemonConnection *c)
+{
+    if (!c->touched)
+    {
+        c->touched = 1;
+        c->nextTouched = d->touched;
+        d->touched = c;
+    }
+}
+
+// send the replies of the connection and watch it for what it needs next
+void daemonSettle(daemonServer *d, daemonConnection *c)
+{
+    unsigned int events = 0;
+    daemonSend(d, c);
+    if (c->waiting == 0 && c->decisions == 0 && (c->closed || ((c->eof || d->ending) && c->outSent == c->outLength)))
+    {
+        daemonDrop(d, c);
+        c->retired = 1;
+        c->nextRetired = d->retired;
+        d->retired = c;
+        return;
+    }
+    if (c->closed)
+    {
+        return;
+    }
+    if (!c->eof && c->waiting == 0 && !d->ending && c->inLength < DAEMON_INPUT_BUFFER && c->outLength - c->outSent < DAEMON_OUTPUT_LIMIT)
+    {
+        events |= EPOLLIN;
+    }
+    if (c->outSent < c->outLength)
+    {
+        events |= EPOLLOUT;
+    }
+    if (events != c->events)
+    {
+        struct epoll_event event = {events, {.ptr = c}};
+        epoll_ctl(d->epoll, EPOLL_CTL_MOD, c->fd, &event);
+        c->events = events;
+    }
+}
 
-                                //check if monitor available
-                                int fcfsSectionNotAvailableFlag_m[monitorAmount] = {[0 ... monitorAmount - 1] = 0};
-                                int prioSectionNotAvailableFlag_m[monitorAmount] = {[0 ... monitorAmount - 1] = 0};
-                                int prioSectionNotdisplaceableFlag_m[monitorAmount] = {[0 ... monitorAmount - 1] = 0};
-                                int prioSectiondisplaceablePrio_m[monitorAmount] = {[0 ... monitorAmount - 1] = 0};
-                                for (i = 0; i < monitorAmount; i++)
-                                { //loop all monitor
-                                    int j;
-                                    if (cur_mSuitable[i] == 1)
-                                    { // only check the monitor with suitable size
-                                        fcfsSectionNotAvailableFlag_m[i] = 0;
-                                        prioSectionNotAvailableFlag_m[i] = 0;
-                                        prioSectionNotdisplaceableFlag_m[i] = 0;
-                                        for (j = 0; j < cur_dur; j++)
-                                        {
-                                            //check monitor available
-                                            int checkSlot = cur_day_offset + I_monitor.offset + (I_monitor.length * i) + cur_time + j;
-                                            if (fcfsSchedule[checkSlot] != '_')
-                                            {
-                                                fcfsSectionNotAvailableFlag_m[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] > 0)
-                                            {
-                                                prioSectionNotAvailableFlag_m[i] = 1;
-                                            }
-                                            if (prioritySchedule_p[checkSlot] >= eventType)
-                                            { //check prio
-                                                prioSectionNotdisplaceableFlag_m[i] = 1;
-                                            }
-                                            else
-                                            {
-                                                prioSectiondisplaceablePrio_m[i] = prioritySchedule_p[checkSlot];
-                                            }
-                                        }
-                                    }
-                                }
-                                for (i = 0; i < monitorAmount; i++)
-                                { //loop all monitor for fcfs choose monitor
-                                    if ((!fcfsSectionNotAvailableFlag_m[i]) && (cur_mSuitable[i] == 1))
-                                    {
-                                        fcfsSelectedMonitor = i;
-                                        break;
-                                    }
-                                }
-                                for (i = 0; i < monitorAmount; i++)
-                                { //loop all monitor for prio choose monitor
-                                    if ((!prioSectionNotAvailableFlag_m[i]) && (cur_mSuitable[i] == 1))
-                                    {
-                                        prioSelectedMonitor = i;
-                                        break;
-                                    }
-                                }
-                                if (prioSelectedMonitor < 0)
-                                {
-                                    int minPrio = 255;
-                                    int min = 255;
-                                    for (i = 0; i < monitorAmount; i++)
-                                    { //loop all monitor for prio displace monitor
-                                        if ((!prioSectionNotdisplaceableFlag_m[i]) && (cur_mSuitable[i] == 1))
-                                        {
-                                            if (minPrio > prioSectiondisplaceablePrio_m[i])
-                                            {
-                                                minPrio = prioSectiondisplaceablePrio_m[i];
-                                                min = i;
-                                            }
-                                        }
-                                    }
-                                    if (min < 255)
-                                    {
-                                        prioSelectedMonitor = min;
-                                    }
-                                }
-                                if (fcfsSelectedMonitor < 0)
-                                {
-                                    fcfs_rej_flag = 1;
-                                }
-                                if (prioSelectedMonitor < 0)
-                                {
-                                    prio_rej_flag = 1;
-                                }
-                            }
-                        }
+// read what the client has sent
+void daemonRead(daemonServer *d, daemonConnection *c)
+{
+    ssize_t n = read(c->fd, c->in + c->inLength, DAEMON_INPUT_BUFFER - c->inLength);
+    if (n > 0)
+    {
+        c->inLength += n;
+    }
+    else if (n == 0)
+    {
+        c->eof = 1;
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        daemonDrop(d, c);
+    }
+}
 
-                        if (fcfs_rej_flag)
-                        { //if this command rejected
-                            fcfsRejectedCommandIndex[fcfsRejectedCount] = S_CommandIndex;
-                            fcfsRejectedCount++;
-                        }
-                        else
-                        { //this command accepted
+// take every pending client
+void daemonAccept(daemonServer *d)
+{
+    int fd;
+    while ((fd = accept(d->listener, NULL, NULL)) >= 0)
+    {
+        daemonConnection *c = calloc(1, sizeof(daemonConnection));
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        if (fd >= d->fdCapacity)
+        {
+            int capacity = d->fdCapacity > 0 ? d->fdCapacity : 64;
+            while (fd >= capacity)
+            {
+                capacity *= 2;
+            }
+            daemonConnection **byFd = realloc(d->byFd, capacity * sizeof(daemonConnection *));
+            if (byFd != NULL)
+            {
+                memset(byFd + d->fdCapacity, 0, (capacity - d->fdCapacity) * sizeof(daemonConnection *));
+                d->byFd = byFd;
+                d->fdCapacity = capacity;
+            }
+        }
+        struct epoll_event event = {EPOLLIN, {.ptr = c}};
+        if (c == NULL || fd >= d->fdCapacity || epoll_ctl(d->epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            printf("Input Module Error: cannot take a client\n");
+            free(c);
+            close(fd);
+            continue;
+        }
+        c->fd = fd;
+        c->events = EPOLLIN;
+        d->byFd[fd] = c;
+    }
+}
 
-                            char tenant_ID = '_';
-                            switch (S_words[1][8])
-                            {
-                            case 'A':
-                                tenant_ID = '0';
-                                break;
-                            case 'B':
-                                tenant_ID = '1';
-                                break;
-                            case 'C':
-                                tenant_ID = '2';
-                                break;
-                            case 'D':
-                                tenant_ID = '3';
-                                break;
-                            case 'E':
-                                tenant_ID = '4';
-                                break;
-                            }
+// the parent has finished the oldest printBookings
+void daemonPrintDone(daemonServer *d)
+{
+    if (d->printHead == d->printLength)
+    {
+        return;
+    }
+    daemonConnection *c = d->printQueue[d->printHead].c;
+    if (--d->printQueue[d->printHead].count == 0)
+    {
+        d->printHead++;
+    }
+    if (--c->waiting == 0)
+    {
+        daemonReply(c, c->deferred);
+        daemonProcess(d, c);
+        daemonTouch(d, c);
+    }
+}
 
-                            if ((eventType != none) && (eventType != bookDevice))
-                            { //insert room
-                                int j;
-                                for (j = 0; j < cur_dur; j++)
-                                {
-                                    int insertSlot = cur_day_offset + I_room.offset + (I_room.length * fcfsSelectedRoom) + cur_time + j;
-                                    if ((cur_time + j) > timeSlotSize)
-                                    {
-                                        insertSlot = insertSlot + day_Length;
-                                    };
-                                    fcfsSchedule[insertSlot] = tenant_ID;
-                                }
-                            }
+// the scheduling module has placed more bookings, answer them in the order they were sent
+void daemonPlaced(daemonServer *d)
+{
+    char reply[128];
+    int placed = admissionPlaced(d->shared);
+    while (d->decisionHead < d->decisionLength && d->decisions[d->decisionHead].id < placed)
+    {
+        daemonDecision *decision = &d->decisions[d->decisionHead++];
+        daemonConnection *c = decision->c;
+        admissionReply(d->shared, d->bookings, decision->id, reply, sizeof(reply));
+        daemonReply(c, reply);
+        if (--c->decisions == 0)
+        {
+            daemonProcess(d, c);
+        }
+        daemonTouch(d, c);
+    }
+}
+
+// 1 if a connection still has replies to send
+int daemonUnsent(const daemonServer *d)
+{
+    int fd;
+    for (fd = 0; fd < d->fdCapacity; fd++)
+    {
+        if (d->byFd[fd] != NULL && d->byFd[fd]->outSent < d->byFd[fd]->outLength)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// serve the clients until endProgram, the bookings go to the store after numOfBooking
+// with an admission pipe, each booking is answered from the shared schedules once it is placed
+void daemonRun(const char *socketPath, int fromParent, int toParent, booking *bookings, int numOfBooking, const sharedSchedule *shared, int admission)
+{
+    daemonServer d;
+    struct sockaddr_un address;
+    struct epoll_event events[DAEMON_EVENT_BATCH];
+    messageBuffer buf = {NULL, 0, 0};
+    int i, fd, running = 1;
+    memset(&d, 0, sizeof(d));
+    d.fromParent = fromParent;
+    d.toParent = toParent;
+    d.bookings = bookings;
+    d.numOfBooking = numOfBooking;
+    d.shared = shared;
+    d.admission = admission;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        printf("Input Module Error: socket path is too long\n");
+        sendMessage(toParent, MSG_END_PROGRAM, NULL, 0);
+        return;
+    }
+    strcpy(address.sun_path, socketPath);
+    d.listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    d.epoll = epoll_create1(EPOLL_CLOEXEC);
+    // a socket file left by a daemon before is replaced
+    unlink(socketPath);
+    struct epoll_event listenEvent = {EPOLLIN, {.ptr = NULL}};
+    struct epoll_event parentEvent = {EPOLLIN, {.ptr = &d}};
+    struct epoll_event admissionEvent = {EPOLLIN, {.ptr = &d.admission}};
+    if (d.listener < 0 || d.epoll < 0 || bind(d.listener, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(d.listener, SOMAXCONN) < 0 ||
+        epoll_ctl(d.epoll, EPOLL_CTL_ADD, d.listener, &listenEvent) < 0 || epoll_ctl(d.epoll, EPOLL_CTL_ADD, fromParent, &parentEvent) < 0 ||
+        (admission >= 0 && epoll_ctl(d.epoll, EPOLL_CTL_ADD, admission, &admissionEvent) < 0))
+    {
+        printf("Input Module Error: cannot listen on %s\n", socketPath);
+        sendMessage(toParent, MSG_END_PROGRAM, NULL, 0);
+        return;
+    }
+    printf("Input Module: listening on %s\n", socketPath);
+    fflush(stdout);
+
+    while (running)
+    {
+        if (d.ending && d.listener >= 0)
+        {
+            // no new clients after endProgram
+            close(d.listener);
+            unlink(socketPath);
+            d.listener = -1;
+        }
+        if (d.ending && d.printHead == d.printLength && d.decisionHead == d.decisionLength && !daemonUnsent(&d))
+        {
+            break;
+        }
+        // after endProgram the replies a client does not read are given up after a second
+        int n = epoll_wait(d.epoll, events, DAEMON_EVENT_BATCH, d.ending ? 1000 : -1);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            break;
+        }
+        for (i = 0; i < n; i++)
+        {
+            daemonConnection *c = events[i].data.ptr;
+            if (c == NULL)
+            {
+                daemonAccept(&d);
+            }
+            else if (c == (void *)&d)
+            {
+                int type = receiveMessage(fromParent, &buf);
+                if (type < 0)
+                {
+                    // parent is gone
+                    running = 0;
+                }
+                else if (type == MSG_END)
+                {
+                    daemonPrintDone(&d);
+                }
+            }
+            else if (c == (void *)&d.admission)
+            {
+                if (receiveMessage(admission, &buf) < 0)
+                {
+                    // the scheduling module is gone after endProgram, nothing more is placed
+                    epoll_ctl(d.epoll, EPOLL_CTL_DEL, admission, NULL);
+                }
+                daemonPlaced(&d);
+            }
+            else if (!c->retired)
+            {
+                if (events[i].events & EPOLLERR)
+                {
+                    daemonDrop(&d, c);
+                }
+                else if (events[i].events & EPOLLIN)
+                {
+                    daemonRead(&d, c);
+                }
+                else if ((events[i].events & EPOLLHUP) && !(events[i].events & EPOLLOUT))
+                {
+                    // the client is gone, nothing to read and the replies cannot be sent
+                    daemonDrop(&d, c);
+                }
+                daemonProcess(&d, c);
+                daemonTouch(&d, c);
+            }
+        }
+        // the bookings of the round go to the parent together, and are in the log before any reply is sent
+        daemonFlush(&d);
+        if (d.logFailed)
+        {
+            break;
+        }
+        while (d.touched != NULL)
+        {
+            daemonConnection *c = d.touched;
+            d.touched = c->nextTouched;
+            c->touched = 0;
+            daemonSettle(&d, c);
+        }
+        while (d.retired != NULL)
+        {
+            daemonConnection *c = d.retired;
+            d.retired = c->nextRetired;
+            free(c->out);
+            free(c);
+        }
+        if (d.printHead == d.printLength)
+        {
+            d.printHead = 0;
+            d.printLength = 0;
+        }
+        if (d.decisionHead == d.decisionLength)
+        {
+            d.decisionHead = 0;
+            d.decisionLength = 0;
+        }
+    }
+
+    for (fd = 0; fd < d.fdCapacity; fd++)
+    {
+        if (d.byFd[fd] != NULL)
+        {
+            daemonConnection *c = d.byFd[fd];
+            daemonDrop(&d, c);
+            free(c->out);
+            free(c);
+        }
+    }
+    if (d.listener >= 0)
+    {
+        close(d.listener);
+        unlink(socketPath);
+    }
+    close(d.epoll);
+    free(d.byFd);
+    free(d.printQueue);
+    free(d.decisions);
+    free(buf.data);
+}
+
+int main(int argc, char **argv)
+{
+    printf("~~ WELCOME TO PolySME ~~ \n");
+    int i, errorLine;
+    // [-daemon <socket path>] [-log <file>] [-admit] [-optBudget <ms>] [catalog]
+    const char *socketPath = NULL, *logFile = NULL;
+    int argument = 1, admit = 0;
+    while (argument < argc && (strcmp(argv[argument], "-daemon") == 0 || strcmp(argv[argument], "-log") == 0 || strcmp(argv[argument], "-admit") == 0 || strcmp(argv[argument], "-optBudget") == 0))
+    {
+        if (strcmp(argv[argument], "-admit") == 0)
+        {
+            admit = 1;
+            argument++;
+            continue;
+        }
+        if (strcmp(argv[argument], "-optBudget") == 0)
+        {
+            char *end;
+            optimalBudget = argument + 1 < argc ? strtoll(argv[argument + 1], &end, 10) : -1;
+            if (optimalBudget <= 0 || *end != '\0')
+            {
+                printf("Error: -optBudget needs a time in milliseconds\n");
+                exit(1);
+            }
+            argument += 2;
+            continue;
+        }
+        if (argument + 1 >= argc)
+        {
+            printf("Error: %s needs a file\n", argv[argument]);
+            exit(1);
+        }
+        if (strcmp(argv[argument], "-daemon") == 0)
+        {
+            socketPath = argv[argument + 1];
+        }
+        else
+        {
+            logFile = argv[argument + 1];
+        }
+        argument += 2;
+    }
+    // the catalog named on the command line, otherwise DIRECTORY_CATALOG, otherwise the built-in one
+    const char *catalogFile = argc > argument ? argv[argument] : DIRECTORY_CATALOG;
+    char *catalogText = readCatalogFile(catalogFile);
+    if (catalogText == NULL && argc > argument)
+    {
+        printf("Error: cannot read the catalog %s\n", catalogFile);
+        exit(1);
+    }
+    if (catalogText == NULL)
+    {
+        catalogFile = "built-in";
+        catalogText = strdup(defaultCatalog);
+    }
+    const char *catalogError = catalogText == NULL ? "out of memory" : catalogLoad(catalogText, &errorLine);
+    if (catalogError != NULL)
+    {
+        if (errorLine > 0)
+        {
+            printf("Error: catalog %s, line %d: %s\n", catalogFile, errorLine, catalogError);
+        }
+        else
+        {
+            printf("Error: catalog %s: %s\n", catalogFile, catalogError);
+        }
+        exit(1);
+    }
+    if ((catalogError = nameTableInit()) != NULL)
+    {
+        printf("Error: %s\n", catalogError);
+        exit(1);
+    }
+    // STEP 0: shared memory for the schedules, inherited by every module
+    sharedSchedule *shared = mmap(NULL, sizeof(sharedSchedule), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED)
+    {
+        printf("Error: shared memory creation error\n");
+        exit(1);
+    }
+    booking *bookings = bookingStoreInit(shared, policyAmount);
+    if (bookings == NULL)
+    {
+        printf("Error: booking store creation error\n");
+        exit(1);
+    }
+    for (i = 0; i < policyAmount; i++)
+    {
+        if (!calendarInit(&shared->schedules[i].cal))
+        {
+            printf("Error: calendar creation error\n");
+            exit(1);
+        }
+    }
+    // the schedules of the snapshot and the bookings of the log are in place before any module starts
+    // restored bookings are placed already, the ones after them up to replayed are placed first
+    int restored = 0, replayed = 0;
+    crcInit();
+    if (logFile != NULL)
+    {
+        snapshotFile = malloc(strlen(logFile) + sizeof(".snapshot"));
+        sprintf(snapshotFile, "%s.snapshot", logFile);
+        const char *snapshotError = snapshotLoad(snapshotFile, shared, bookings, &restored);
+        if (snapshotError != NULL)
+        {
+            printf("Booking log: %s: %s, the whole log is replayed\n", snapshotFile, snapshotError);
+        }
+        const char *logError = logOpen(&commandLog, logFile, bookings, restored, &replayed);
+        if (logError != NULL)
+        {
+            printf("Error: %s: %s\n", logFile, logError);
+            exit(1);
+        }
+    }
+    // the bookings cancelled before cannot be changed again
+    bookingChanged = calloc(BOOKING_STORE_CAPACITY, 1);
+    if (bookingChanged == NULL)
+    {
+        printf("Error: booking store creation error\n");
+        exit(1);
+    }
+    for (i = 0; i < replayed; i++)
+    {
+        if (bookings[i].type == cancelBooking)
+        {
+            bookingChanged[bookingRoot(bookings, i)] = 1;
+        }
+    }
+    if (restored > 0)
+    {
+        printf("-> [Restored: %d bookings from %s]\n", restored, snapshotFile);
+    }
+    if (replayed > restored)
+    {
+        printf("-> [Replayed: %d bookings from %s]\n", replayed - restored, logFile);
+    }
+    fflush(stdout);
+    // STEP 1: fork and pipe for INPUT MODULE
+    int inputPipe[2][2];
+    pid_t inputCid;
+    // create pipe, parent use [0][1] write, child use [1][1] write
+    for (i = 0; i < 2; i++)
+    {
+        if (pipe(inputPipe[i]) < 0)
+        {
+            printf("Error: Pipe creation error\n");
+            exit(1);
+        }
+    }
+    // with -admit, the scheduling module rings the input module on [1] when bookings are placed
+    // the ring is never waited for, a full pipe already has one
+    int admissionPipe[2] = {-1, -1};
+    if (admit && (pipe(admissionPipe) < 0 || fcntl(admissionPipe[1], F_SETFL, O_NONBLOCK) < 0))
+    {
+        printf("Error: Pipe creation error\n");
+        exit(1);
+    }
+
+    // create INPUT MODULE child process
+    if ((inputCid = fork()) < 0)
+    {
+        printf("Error: fork input module error\n");
+        exit(1);
+    }
+    else if (inputCid == 0)
+    {
+        // INPUT MODULE
+        close(inputPipe[1][0]);
+        close(inputPipe[0][1]);
+        if (admit)
+        {
+            close(admissionPipe[1]);
+        }
+        // printf("Input Moudle: Started.\n");
+
+        char buf[COMMAND_CHAR_SIZE];
+        messageBuffer parentBuf = {NULL, 0, 0};
+        messageBuffer admissionBuf = {NULL, 0, 0};
+        int invalid = 0;
+        int n;
+        char *words[COMMAND_WORD_LIMIT];
+        int wordCount;
+        // the next booking id
+        int numOfBooking = replayed;
+        while (1)
+        {
+            if (socketPath != NULL)
+            {
+                // daemon mode: the commands come from the socket clients until endProgram
+                daemonRun(socketPath, inputPipe[0][0], inputPipe[1][1], bookings, numOfBooking, shared, admissionPipe[0]);
+                break;
+            }
+            if (invalid == 1)
+            {
+                sendMessage(inputPipe[1][1], MSG_INVALID, NULL, 0);
+                invalid = 0;
+            }
+            // Read Input
+            int type = receiveMessage(inputPipe[0][0], &parentBuf);
+            if (type < 0)
+            {
+                // parent is gone
+                break;
+            }
+            if (type != MSG_PROMPT)
+            {
+                printf("Input Error: unexpected message type %d\n", type);
+                continue;
+            }
+            // read from stdin
+            printf("Please enter booking:\n");
+            n = read(STDIN_FILENO, buf, COMMAND_CHAR_SIZE);
+            if (n <= 1)
+            {
+                printf("Input Module Error: entering empty line\n");
+                invalid = 1;
+                continue;
+            }
+            buf[--n] = 0;
+            // printf("Input Module: %d char in input line: [%s]\n", n, buf);
+
+            // Error handling
+            // can handle: wrong word count, wrong tenant name, wrong device name, wrong date/time/duration
+            wordCount = splitWords(buf, words, COMMAND_WORD_LIMIT);
+            if (wordCount == 0)
+            {
+                printf("Input Module Error: entering empty line\n");
+                invalid = 1;
+                continue;
+            }
+
+            // handle addBatch command
+            if (strcmp(words[0], "addBatch") == 0)
+            {
+                if (wordCount < 2)
+                {
+                    printf("Input Module Error: addBatch needs a file\n");
+                    invalid = 1;
+                    continue;
+                }
+                int prints = 0;
+                int result = loadBatch(words[1] + 1, inputPipe[1][1], bookings, &numOfBooking, &prints);
+                if (result < 0)
+                {
+                    printf("Input Module: error openning file\n");
+                    invalid = 1;
+                }
+                else if (result == 1)
+                {
+                    // endProgram in the file
+                    break;
+                }
+                continue;
+            }
 
-                            if ((S_numOfWords > 5) || (eventType == bookDevice))
-                            { //insert device
-                                int j;
-                                if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 'p')))
-                                { //[projector]
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_p = cur_day_offset + I_projector.offset + (I_projector.length * fcfsSelectedProjector) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_p = insertSlot_p + day_Length;
-                                        };
-                                        fcfsSchedule[insertSlot_p] = tenant_ID;
-                                    }
-                                }
-                                if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 's')))
-                                { //[screen]
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_s = cur_day_offset + I_screen.offset + (I_screen.length * fcfsSelectedScreen) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_s = insertSlot_s + day_Length;
-                                        };
-                                        fcfsSchedule[insertSlot_s] = tenant_ID;
-                                    }
-                                }
+            // Transfer to parent using pipe
+            if (strcmp(words[0], "endProgram") == 0)
+            {
+                // printf("Input Module: end program command is received.\n");
+                sendMessage(inputPipe[1][1], MSG_END_PROGRAM, NULL, 0);
+                break;
+            }
+            else if (strcmp(words[0], "printBookings") == 0)
+            {
+                unsigned int policyMask;
+                const char *error = parsePolicies(words, wordCount, &policyMask);
+                if (error != NULL)
+                {
+                    printf("Input Module Error: %s\n", error);
+                    invalid = 1;
+                }
+                else
+                {
+                    sendMessage(inputPipe[1][1], MSG_PRINT, &policyMask, sizeof(policyMask));
+                }
+            }
+            else
+            {
+                // a booking, cancelBooking or moveBooking command, parsed here once into the store
+                if (numOfBooking >= BOOKING_STORE_CAPACITY)
+                {
+                    printf("Input Module Error: booking store is full\n");
+                    invalid = 1;
+                    continue;
+                }
+                const char *error = parseEntry(words, wordCount, bookings, numOfBooking);
+                if (error != NULL)
+                {
+                    printf("Input Module Error: %s\n", error);
+                    invalid = 1;
+                    continue;
+                }
+                int count = 1, invalidLines = 0;
+                if (!flushBatch(inputPipe[1][1], bookings, &numOfBooking, &count, &invalidLines))
+                {
+                    break;
+                }
+                if (admit)
+                {
+                    // the answer instead of [Pending], once the scheduling module has placed it
+                    char reply[128];
+                    while (admissionPlaced(shared) < numOfBooking && receiveMessage(admissionPipe[0], &admissionBuf) >= 0)
+                        ;
+                    if (admissionPlaced(shared) >= numOfBooking)
+                    {
+                        admissionReply(shared, bookings, numOfBooking - 1, reply, sizeof(reply));
+                        printf("%s", reply);
+                    }
+                }
+            }
+        }
+        free(parentBuf.data);
+        free(admissionBuf.data);
+        if (admit)
+        {
+            close(admissionPipe[0]);
+        }
 
-                                if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'w')))
-                                { //[webcam]
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_w = cur_day_offset + I_webcam.offset + (I_webcam.length * fcfsSelectedWebcam) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_w = insertSlot_w + day_Length;
-                                        };
-                                        fcfsSchedule[insertSlot_w] = tenant_ID;
-                                    }
-                                }
-                                if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'm')))
-                                { //[monitor]
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_m = cur_day_offset + I_monitor.offset + (I_monitor.length * fcfsSelectedMonitor) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_m = insertSlot_m + day_Length;
-                                        };
-                                        fcfsSchedule[insertSlot_m] = tenant_ID;
-                                    }
-                                }
-                            }
-                        }
-                        if (prio_rej_flag)
-                        { //if this command rejected
-                            priorityRejectedCommandIndex[priorityRejectedCount] = S_CommandIndex;
-                            priorityRejectedCount++;
-                        }
-                        else
-                        { //this command accepted
+        // clean up
+        close(inputPipe[1][1]);
+        close(inputPipe[0][0]);
+        // printf("Input Moudle: I have completed!.\n");
+    }
+    else
+    {
+        // parent process
+        close(inputPipe[1][1]);
+        close(inputPipe[0][0]);
 
-                            char tenant_ID = '_';
-                            switch (S_words[1][8])
-                            {
-                            case 'A':
-                                tenant_ID = '0';
-                                break;
-                            case 'B':
-                                tenant_ID = '1';
-                                break;
-                            case 'C':
-                                tenant_ID = '2';
-                                break;
-                            case 'D':
-                                tenant_ID = '3';
-                                break;
-                            case 'E':
-                                tenant_ID = '4';
-                                break;
-                            }
+        // STEP 2: fork/pipe SCHEDULING MODULE
+        int schedulePipe[2][2];
+        pid_t scheduleCid;
+        // create pipe, parent use [0][1] write, child use [1][1] write
+        for (i = 0; i < 2; i++)
+        {
+            if (pipe(schedulePipe[i]) < 0)
+            {
+                printf("Error: input pipe creation error\n");
+                exit(1);
+            }
+        }
+        if ((scheduleCid = fork()) < 0)
+        {
+            printf("Error: fork scheduling module error\n");
+            exit(1);
+        }
+        else if (scheduleCid == 0)
+        {
+            // Scheduling module (Part 2)
+            // the schedules live as long as the module: each booking command is placed
+            // when the parent forwards it, printBookings only sends the current result
+            // -- USEFUL DATA --
+            // the bookings are read from the store
+            // storing the number of command
+            int numOfCommand = 0;
+            // number of commands already placed on the schedules
+            int numOfScheduled = restored;
+            // number of commands in the last snapshot
+            int numOfSnapshot = restored;
 
-                            if ((eventType != none) && (eventType != bookDevice))
-                            { //insert room
-                                int j, k, l;
-                                for (j = 0; j < cur_dur; j++)
-                                {
+            // closed unused pipes
+            close(inputPipe[0][1]);
+            close(inputPipe[1][1]);
+            close(schedulePipe[1][0]);
+            close(schedulePipe[0][1]);
+            if (admit)
+            {
+                close(admissionPipe[0]);
+            }
+            // printf("Schedule Module: Created.\n");
 
-                                    int insertSlot = cur_day_offset + I_room.offset + (I_room.length * prioSelectedRoom) + cur_time + j;
-                                    if ((cur_time + j) > timeSlotSize)
-                                    {
-                                        insertSlot = insertSlot + day_Length;
-                                    };
-                                    if (prioritySchedule_c[insertSlot] >= 0)
-                                    { //reject the lower prio event
-                                        int rejectedCmd = prioritySchedule_c[insertSlot];
-                                        priorityRejectedCommandIndex[priorityRejectedCount] = rejectedCmd;
-                                        priorityRejectedCount++;
-                                        for (k = 0; k < 7; k++)
-                                        {
-                                            for (l = date_Length; l < day_Length; l++)
-                                                if (prioritySchedule_c[k * day_Length + l] == rejectedCmd)
-                                                {
-                                                    prioritySchedule[k * day_Length + l] = '_';
-                                                    prioritySchedule_p[k * day_Length + l] = none;
-                                                    prioritySchedule_c[k * day_Length + l] = -1;
-                                                }
-                                        }
-                                    }
-                                    prioritySchedule[insertSlot] = tenant_ID;
-                                    prioritySchedule_p[insertSlot] = eventType;
-                                    prioritySchedule_c[insertSlot] = S_CommandIndex;
-                                }
-                            }
+            // use schedulePipe[1][1] to WRITE TO PARENT
+            // use schedulePipe[0][0] to READ FROM PARENT
 
-                            if ((S_numOfWords > 5) || (eventType == bookDevice))
-                            { //insert device
-                                if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 'p')))
-                                { //[projector]
-                                    int j, k, l;
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_p = cur_day_offset + I_projector.offset + (I_projector.length * prioSelectedProjector) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_p = insertSlot_p + day_Length;
-                                        };
-                                        if (prioritySchedule_c[insertSlot_p] > 0)
-                                        { //reject the lower prio event
-                                            int rejectedCmd = prioritySchedule_c[insertSlot_p];
-                                            priorityRejectedCommandIndex[priorityRejectedCount] = rejectedCmd;
-                                            priorityRejectedCount++;
-                                            for (k = 0; k < 7; k++)
-                                            {
-                                                for (l = date_Length; l < day_Length; l++)
-                                                    if (prioritySchedule_c[k * day_Length + l] == rejectedCmd)
-                                                    {
-                                                        prioritySchedule[k * day_Length + l] = '_';
-                                                        prioritySchedule_p[k * day_Length + l] = none;
-                                                        prioritySchedule_c[k * day_Length + l] = -1;
-                                                    }
-                                            }
-                                        }
-                                        prioritySchedule[insertSlot_p] = tenant_ID;
-                                        prioritySchedule_p[insertSlot_p] = eventType;
-                                        prioritySchedule_c[insertSlot_p] = S_CommandIndex;
-                                    }
-                                }
-                                if ((devicePair == 1) || ((eventType == bookDevice) && (S_words[5][0] == 's')))
-                                { //[screen]
-                                    int j, k, l;
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_s = cur_day_offset + I_screen.offset + (I_screen.length * prioSelectedScreen) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_s = insertSlot_s + day_Length;
-                                        };
-                                        if (prioritySchedule_c[insertSlot_s] >= 0)
-                                        { //reject the lower prio event
-                                            int rejectedCmd = prioritySchedule_c[insertSlot_s];
-                                            priorityRejectedCommandIndex[priorityRejectedCount] = rejectedCmd;
-                                            priorityRejectedCount++;
-                                            for (k = 0; k < 7; k++)
-                                            {
-                                                for (l = date_Length; l < day_Length; l++)
-                                                    if (prioritySchedule_c[k * day_Length + l] == rejectedCmd)
-                                                    {
-                                                        prioritySchedule[k * day_Length + l] = '_';
-                                                        prioritySchedule_p[k * day_Length + l] = none;
-                                                        prioritySchedule_c[k * day_Length + l] = -1;
-                                                    }
-                                            }
-                                        }
-                                        prioritySchedule[insertSlot_s] = tenant_ID;
-                                        prioritySchedule_p[insertSlot_s] = eventType;
-                                        prioritySchedule_c[insertSlot_s] = S_CommandIndex;
-                                    }
-                                }
+            // live schedules, in the shared region, unless they come from the snapshot
+            for (i = 0; i < policyAmount && restored == 0; i++)
+            {
+                policies[i].init(&shared->schedules[i]);
+            }
+            __atomic_store_n(&shared->placed, numOfScheduled, __ATOMIC_RELEASE);
 
-                                if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'w')))
-                                { //[webcam]
-                                    int j, k, l;
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_w = cur_day_offset + I_webcam.offset + (I_webcam.length * prioSelectedWebcam) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_w = insertSlot_w + day_Length;
-                                        };
-                                        if (prioritySchedule_c[insertSlot_w] >= 0)
-                                        { //reject the lower prio event
-                                            int rejectedCmd = prioritySchedule_c[insertSlot_w];
-                                            priorityRejectedCommandIndex[priorityRejectedCount] = rejectedCmd;
-                                            priorityRejectedCount++;
-                                            for (k = 0; k < 7; k++)
-                                            {
-                                                for (l = date_Length; l < day_Length; l++)
-                                                    if (prioritySchedule_c[k * day_Length + l] == rejectedCmd)
-                                                    {
-                                                        prioritySchedule[k * day_Length + l] = '_';
-                                                        prioritySchedule_p[k * day_Length + l] = none;
-                                                        prioritySchedule_c[k * day_Length + l] = -1;
-                                                    }
-                                            }
-                                        }
-                                        prioritySchedule[insertSlot_w] = tenant_ID;
-                                        prioritySchedule_p[insertSlot_w] = eventType;
-                                        prioritySchedule_c[insertSlot_w] = S_CommandIndex;
-                                    }
-                                }
-                                if ((devicePair == 2) || ((eventType == bookDevice) && (S_words[5][0] == 'm')))
-                                { //[monitor]
-                                    int j, k, l;
-                                    for (j = 0; j < cur_dur; j++)
-                                    {
-                                        int insertSlot_m = cur_day_offset + I_monitor.offset + (I_monitor.length * prioSelectedMonitor) + cur_time + j;
-                                        if ((cur_time + j) > timeSlotSize)
-                                        {
-                                            insertSlot_m = insertSlot_m + day_Length;
-                                        };
-                                        if (prioritySchedule_c[insertSlot_m] >= 0)
-                                        { //reject the lower prio event
-                                            int rejectedCmd = prioritySchedule_c[insertSlot_m];
-                                            priorityRejectedCommandIndex[priorityRejectedCount] = rejectedCmd;
-                                            priorityRejectedCount++;
-                                            for (k = 0; k < 7; k++)
-                                            {
-                                                for (l = date_Length; l < day_Length; l++)
-                                                    if (prioritySchedule_c[k * day_Length + l] == rejectedCmd)
-                                                    {
-                                                        prioritySchedule[k * day_Length + l] = '_';
-                                                        prioritySchedule_p[k * day_Length + l] = none;
-                                                        prioritySchedule_c[k * day_Length + l] = -1;
-                                                    }
-                                            }
-                                        }
-                                        prioritySchedule[insertSlot_m] = tenant_ID;
-                                        prioritySchedule_p[insertSlot_m] = eventType;
-                                        prioritySchedule_c[insertSlot_m] = S_CommandIndex;
-                                    }
-                                }
-                            }
-                        }
+            // waiting to receive commands from parent
+            messageBuffer buf = {NULL, 0, 0};
+            while (1)
+            {
+                int type = receiveMessage(schedulePipe[0][0], &buf);
+                // whole program is finish, end child
+                if (type < 0 || type == MSG_CLOSE)
+                {
+                    // printf("Scheduling module: closing...\n");
+                    for (i = 0; i < policyAmount; i++)
+                    {
+                        compactRejected(&shared->schedules[i]);
                     }
-
-                    if (strcmp(mode, "-fcfs") == 0)
+                    if (snapshotFile != NULL && numOfScheduled > numOfSnapshot && !snapshotWrite(snapshotFile, shared, bookings, numOfScheduled))
                     {
-                        write(schedulePipe[1][1], fcfsSchedule, SCHEDULE_STRING_LENGTH);
-                        int length = snprintf(NULL, 0, "%d", fcfsRejectedCount);
-                        char *str = malloc(length + 1);
-                        snprintf(str, length + 1, "%d", fcfsRejectedCount);
-                        write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                        free(str);
-                        for (i = 0; i < fcfsRejectedCount; i++)
-                        {
-                            length = snprintf(NULL, 0, "%d", fcfsRejectedCommandIndex[i]);
-                            str = malloc(length + 1);
-                            snprintf(str, length + 1, "%d", fcfsRejectedCommandIndex[i]);
-                            write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                            free(str);
-                        }
+                        printf("Scheduling module Error, cannot write the snapshot\n");
                     }
-                    else if (strcmp(mode, "-prio") == 0)
+                    break;
+                }
+                if (type == MSG_PRINT)
+                {
+                    // printBookings: the schedules are already in the shared region,
+                    // complete the selected ones and publish them as a new generation for output and analyzer
+                    unsigned int policyMask = buf.length == sizeof(policyMask) ? *(unsigned int *)buf.data : 0;
+                    for (i = 0; i < policyAmount; i++)
                     {
-                        write(schedulePipe[1][1], prioritySchedule, SCHEDULE_STRING_LENGTH);
-                        int length = snprintf(NULL, 0, "%d", priorityRejectedCount);
-                        char *str = malloc(length + 1);
-                        snprintf(str, length + 1, "%d", priorityRejectedCount);
-                        write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                        free(str);
-                        for (i = 0; i < priorityRejectedCount; i++)
+                        compactRejected(&shared->schedules[i]);
+                        if (policies[i].finalize != NULL && (policyMask & (1u << i)))
                         {
-                            length = snprintf(NULL, 0, "%d", priorityRejectedCommandIndex[i]);
-                            str = malloc(length + 1);
-                            snprintf(str, length + 1, "%d", priorityRejectedCommandIndex[i]);
-                            write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                            free(str);
+                            policies[i].finalize(&shared->schedules[i], bookings, numOfScheduled);
                         }
                     }
-                    else if (strcmp(mode, "-ALL") == 0)
+                    shared->generation++;
+                    sendMessage(schedulePipe[1][1], MSG_END, &shared->generation, sizeof(shared->generation));
+                    continue;
+                }
+                if ((type != MSG_BOOKING) || (buf.length != 2 * sizeof(int)))
+                {
+                    printf("Scheduling module: unexpected message type %d\n", type);
+                    continue;
+                }
+
+                // new bookings in the store: place them on both schedules
+                int *range = (int *)buf.data;
+                numOfCommand = range[0] + range[1];
+
+                scheduleBookings(shared->schedules, bookings, numOfScheduled, numOfCommand);
+                numOfScheduled = numOfCommand;
+                // the assignments are written before the count that shows them
+                __atomic_store_n(&shared->placed, numOfScheduled, __ATOMIC_RELEASE);
+                if (admit)
+                {
+                    sendMessage(admissionPipe[1], MSG_PLACED, NULL, 0);
+                }
+                if (snapshotFile != NULL && numOfScheduled - numOfSnapshot >= SNAPSHOT_INTERVAL)
+                {
+                    for (i = 0; i < policyAmount; i++)
                     {
-                        write(schedulePipe[1][1], fcfsSchedule, SCHEDULE_STRING_LENGTH);
-                        write(schedulePipe[1][1], prioritySchedule, SCHEDULE_STRING_LENGTH);
-                        int length = snprintf(NULL, 0, "%d", fcfsRejectedCount);
-                        char *str = malloc(length + 1);
-                        snprintf(str, length + 1, "%d", fcfsRejectedCount);
-                        write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                        free(str);
-                        for (i = 0; i < fcfsRejectedCount; i++)
-                        {
-                            length = snprintf(NULL, 0, "%d", fcfsRejectedCommandIndex[i]);
-                            str = malloc(length + 1);
-                            snprintf(str, length + 1, "%d", fcfsRejectedCommandIndex[i]);
-                            write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                            free(str);
-                        }
-                        write(schedulePipe[1][1], "&&", COMMAND_CHAR_SIZE);
-                        length = snprintf(NULL, 0, "%d", priorityRejectedCount);
-                        str = malloc(length + 1);
-                        snprintf(str, length + 1, "%d", priorityRejectedCount);
-                        write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                        free(str);
-                        for (i = 0; i < priorityRejectedCount; i++)
-                        {
-                            length = snprintf(NULL, 0, "%d", priorityRejectedCommandIndex[i]);
-                            str = malloc(length + 1);
-                            snprintf(str, length + 1, "%d", priorityRejectedCommandIndex[i]);
-                            write(schedulePipe[1][1], str, COMMAND_CHAR_SIZE);
-                            free(str);
-                        }
+                        compactRejected(&shared->schedules[i]);
+                    }
+                    if (!snapshotWrite(snapshotFile, shared, bookings, numOfScheduled))
+                    {
+                        printf("Scheduling module Error, cannot write the snapshot\n");
                     }
-                    isFirstLine = 1;
-                    numOfCommand = 0;
+                    // tried again after the next interval
+                    numOfSnapshot = numOfScheduled;
                 }
             }
 
+            free(buf.data);
             close(schedulePipe[1][1]);
             close(schedulePipe[0][0]);
+            if (admit)
+            {
+                close(admissionPipe[1]);
+            }
             // printf("Schedule Module: done\n");
         }
         else
@@ -1604,6 +5048,11 @@ int main()
             // Parent
             close(schedulePipe[1][1]);
             close(schedulePipe[0][0]);
+            if (admit)
+            {
+                close(admissionPipe[0]);
+                close(admissionPipe[1]);
+            }
             // STEP 3: fork/pipe OUTPUT MODULE
             int outputPipe[2][2];
             pid_t outputCid;
@@ -1632,589 +5081,85 @@ int main()
                 close(outputPipe[0][1]);
                 // printf("Output Module: started.\n");
 
-                int n;
-                int isFirstLine = 1;
-                char buf[COMMAND_CHAR_SIZE];
-                char fcfsSchedule[SCHEDULE_STRING_LENGTH + 1];
-                char prioSchedule[SCHEDULE_STRING_LENGTH + 1];
+                messageBuffer buf = {NULL, 0, 0};
 
-                char mode[10];
-                char commandHistory[MAX_COMMAND][COMMAND_CHAR_SIZE];
+                unsigned int policyMask = 0;
                 int numOfCommand = 0;
+                reportWriter report = {-1, NULL, 0, 0};
 
                 while (1)
                 {
-                    n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                    buf[n] = 0;
-                    // printf("Output module: received [%s]\n", buf);
-                    if (strcmp(buf, "CLOSE") == 0)
+                    int type = receiveMessage(outputPipe[0][0], &buf);
+                    // printf("Output module: received type %d\n", type);
+                    if (type < 0 || type == MSG_CLOSE)
                     {
                         // printf("output module: closing...\n");
                         break;
                     }
-                    else if (strcmp(buf, "END") == 0)
+                    else if (type == MSG_END)
                     {
-                        // -- Loging the data received from parent
-                        // printf("Ouput: num of command = %d\n", numOfCommand);
-                        // printf("Ouput: fcfs rejected amount = %d\n", fcfsRejectedCount);
-                        // printf("Ouput: num of command = %d\n", priorityRejectedCount);
-                        // printf("Output: command history:\n");
-                        // for (i = 0; i < numOfCommand; i++)
-                        // {
-                        //     printf("[%s]\n", commandHistory[i]);
-                        // }
-                        // printf("Output: fcfs rejected index: [");
-                        // for (i = 0; i < fcfsRejectedCount; i++)
-                        // {
-                        //     printf("%d, ", fcfsRejectedCommandIndex[i]);
-                        // }
-                        // printf("]\n");
-                        // printf("Output: priority rejected index: [");
-                        // for (i = 0; i < priorityRejectedCount; i++)
-                        // {
-                        //     printf("%d, ", priorityRejectedCommandIndex[i]);
-                        // }
-                        // printf("]\n");
-                        // printf("Output: fcfs Schedule = %s\n", fcfsSchedule);
-                        // printf("Output: prio schedule = %s\n", prioSchedule);
-
-                        int printFCFS = 0;
-                        int printPRIO = 0;
-
-                        if (strcmp(mode, "-fcfs") == 0)
-                        {
-                            printFCFS = 1;
-                        }
-                        else if (strcmp(mode, "-prio") == 0)
-                        {
-                            printPRIO = 1;
-                        }
-                        else if (strcmp(mode, "-ALL") == 0)
+                        // the payload is the generation of the schedules to print
+                        if (buf.length != sizeof(unsigned int) || *(unsigned int *)buf.data != shared->generation)
                         {
-                            printFCFS = 1;
-                            printPRIO = 1;
+                            printf("Output module Error, schedules are not published\n");
+                            numOfCommand = 0;
+                            sendMessage(outputPipe[1][1], MSG_END, NULL, 0);
+                            continue;
                         }
-
                         // print to file
-                        FILE *fp;
                         char *currentUnixTime = getStringFromInt(time(NULL));
-                        char fileName[] = DIRECTORY_OUTPUT_PREFIX;
-                        strcat(fileName, currentUnixTime);
-                        strcat(fileName, ".txt");
+                        char fileName[64];
+                        snprintf(fileName, sizeof(fileName), "%s%s.txt", DIRECTORY_OUTPUT_PREFIX, currentUnixTime);
                         printf(" -> [output file: %s]\n", fileName);
-                        fp = fopen(fileName, "w");
                         free(currentUnixTime);
-                        if (fp == NULL)
+                        if (!reportOpen(&report, fileName))
                         {
                             printf("Output module Error, error in opening\n");
                             // end
-                            fcfsRejectedCount = 0;
-                            priorityRejectedCount = 0;
                             numOfCommand = 0;
-                            fcfsSchedule[0] = 0;
-                            prioSchedule[0] = 0;
+                            sendMessage(outputPipe[1][1], MSG_END, NULL, 0);
                             continue;
                         }
 
-                        int u, h, deviceIndexStart, rejected, endtime, duration, numOfWords, startTimeInt, needFindRoom, participant, isNextDay;
-                        int oneDayScheduleSize = (roomAmount + webcamAmount + monitorAmount + projectorAmount + screenAmount) * 24 + 10;
-                        char startTime[3];
-                        char room[20];
-                        char tempDate[11];
-                        char tempSchedule[25];
-                        char *endTimeString;
-                        char allDeviceString[100];
-                        if (printFCFS == 1)
+                        int printed = 0;
+                        for (i = 0; i < policyAmount; i++)
                         {
-                            // print all accepted bookings
-                            fprintf(fp, "*** Room Booking - ACCEPTED / FCFS ***\n");
-                            for (i = 0; i < tenantAmount; i++)
+                            if (!(policyMask & (1u << i)))
                             {
-                                fprintf(fp, "%s has the following bookings:\n", tenantNames[i]);
-                                fprintf(fp, "Date        Start  End                  Type         Room     Device           \n");
-                                fprintf(fp, "=================================================================\n");
-                                for (u = 0; u < numOfCommand; u++)
-                                {
-                                    strcpy(room, "XXX");
-                                    rejected = 0;
-                                    for (h = 0; h < fcfsRejectedCount; h++)
-                                    {
-                                        if (fcfsRejectedCommandIndex[h] == u)
-                                        {
-                                            rejected = 1;
-                                            break;
-                                        }
-                                    }
-                                    if (rejected == 0)
-                                    {
-                                        numOfWords = getNumOfWord(commandHistory[u], strlen(commandHistory[u]));
-                                        char **words = splitCommand(commandHistory[u], strlen(commandHistory[u]));
-                                        words[1]++;
-                                        // for (i = 0; i < numOfWords; i++) {
-                                        //     printf("Output: word[%d] = %s\n", i, words[i]);
-                                        // }
-                                        startTime[0] = words[3][0];
-                                        startTime[1] = words[3][1];
-                                        startTime[2] = 0;
-                                        duration = getIntFromString(words[4]);
-                                        //printf("Output: duration of [%s] is %d\n", words[4], duration);
-                                        startTimeInt = getIntFromString(startTime);
-                                        //printf("Output: start time of [%s] is %d\n", startTime, startTimeInt);
-                                        endtime = getIntFromString(startTime) + duration;
-                                        if (endtime > 23)
-                                        {
-                                            isNextDay = 1;
-                                            endtime = endtime - 24;
-                                        }
-                                        else
-                                        {
-                                            isNextDay = 0;
-                                        }
-                                        //printf("Output: end time is %d\n", endtime);
-                                        endTimeString = getStringFromInt(endtime);
-                                        if (strcmp(words[0], "bookDevice") == 0)
-                                        {
-                                            needFindRoom = 0;
-                                            deviceIndexStart = 5;
-                                            strcpy(words[0], "*");
-                                        }
-                                        else
-                                        {
-                                            needFindRoom = 1;
-                                            deviceIndexStart = 6;
-                                            words[0] = words[0] + 3;
-                                        }
-                                        // format devices string
-                                        allDeviceString[0] = 0;
-                                        for (h = deviceIndexStart; h < numOfWords; h++)
-                                        {
-                                            strcat(allDeviceString, words[h]);
-                                            strcat(allDeviceString, " ");
-                                        }
-
-                                        // finding the room
-                                        // search for each room (with suitable room size)
-                                        // check if the time slot (from start to end) is occupied by the tanent
-                                        h = 0;
-                                        int r, q, isOnThatDay;
-                                        participant = getIntFromString(words[5]);
-                                        if (needFindRoom == 1)
-                                        {
-                                            // printf("Output: checking rooms (fcfs) for command %d\n", u);
-                                            while (h < SCHEDULE_STRING_LENGTH)
-                                            {
-                                                memcpy(tempDate, &fcfsSchedule[h], 10);
-                                                tempDate[10] = '\0';
-                                                // check if date is the same
-                                                //printf("Output: checking date: %s vs %s\n", tempDate, words[2]);
-                                                if (strcmp(tempDate, words[2]) == 0)
-                                                {
-                                                    // find each room and check availability
-                                                    //printf("Output: found same date: %s\n", tempDate);
-                                                    for (r = 0; r < roomAmount; r++)
-                                                    {
-                                                        if (roomCapacity[r] >= participant)
-                                                        {
-                                                            //printf("Output: found room with good size: %s\n", roomNames[r]);
-                                                            int tempStart = h + 10 + r * 24 + startTimeInt;
-                                                            isOnThatDay = 1;
-                                                            char t = i + '0';
-                                                            for (q = 0; q < duration; q++)
-                                                            {
-                                                                if (fcfsSchedule[tempStart + q] != t)
-                                                                {
-                                                                    isOnThatDay = 0;
-                                                                    break;
-                                                                }
-                                                            }
-                                                            if (isOnThatDay == 1)
-                                                            {
-                                                                strcpy(room, roomNames[r]);
-                                                                break;
-                                                            }
-                                                        }
-                                                    }
-                                                }
-                                                h = h + oneDayScheduleSize;
-                                            }
-                                        }
-                                        else
-                                        {
-                                            strcpy(room, "*");
-                                        }
-
-                                        if (strcmp(words[1], tenantNames[i]) == 0)
-                                        {
-                                            if (isNextDay == 0)
-                                            {
-                                                fprintf(fp, "%-12s%-7s%2s:00                %-13s%-9s%s\n", words[2], words[3], endTimeString, words[0], room, allDeviceString);
-                                            }
-                                            else
-                                            {
-                                                fprintf(fp, "%-12s%-7s%2s:00(the next day)  %-13s%-9s%s\n", words[2], words[3], endTimeString, words[0], room, allDeviceString);
-                                            }
-                                        }
-                                        free(words);
-                                    }
-                                }
-                                fprintf(fp, "\n");
+                                continue;
                             }
-                            fprintf(fp, "\n");
-
-                            // print all rejected command
-                            fprintf(fp, "*** Room Booking - REJECTED / FCFS ***\n");
-                            for (i = 0; i < tenantAmount; i++)
+                            if (printed++ > 0)
                             {
-                                fprintf(fp, "%s has the following bookings:\n", tenantNames[i]);
-                                fprintf(fp, "Date        Start  End                  Type         Device           \n");
-                                fprintf(fp, "=================================================================\n");
-                                for (u = 0; u < fcfsRejectedCount; u++)
-                                {
-                                    char currentCmd[COMMAND_CHAR_SIZE];
-                                    strcpy(currentCmd, commandHistory[fcfsRejectedCommandIndex[u]]);
-                                    numOfWords = getNumOfWord(currentCmd, strlen(currentCmd));
-                                    char **words = splitCommand(currentCmd, strlen(currentCmd));
-                                    words[1]++;
-                                    //printf("Output: comparing %s to %s\n", words[1], tenantNames[i]);
-                                    if (strcmp(words[1], tenantNames[i]) == 0)
-                                    {
-                                        startTime[0] = words[3][0];
-                                        startTime[1] = words[3][1];
-                                        startTime[2] = 0;
-                                        duration = getIntFromString(words[4]);
-                                        //printf("Output: duration of [%s] is %d\n", words[4], duration);
-                                        startTimeInt = getIntFromString(startTime);
-                                        //printf("Output: start time of [%s] is %d\n", startTime, startTimeInt);
-                                        endtime = getIntFromString(startTime) + duration;
-                                        if (endtime > 23)
-                                        {
-                                            isNextDay = 1;
-                                            endtime = endtime - 24;
-                                        }
-                                        else
-                                        {
-                                            isNextDay = 0;
-                                        }
-                                        //printf("Output: end time is %d\n", endtime);
-                                        endTimeString = getStringFromInt(endtime);
-                                        if (strcmp(words[0], "bookDevice") == 0)
-                                        {
-                                            deviceIndexStart = 5;
-                                            strcpy(words[0], "*");
-                                        }
-                                        else
-                                        {
-                                            deviceIndexStart = 6;
-                                            words[0] = words[0] + 3;
-                                        }
-                                        allDeviceString[0] = 0;
-                                        for (h = deviceIndexStart; h < numOfWords; h++)
-                                        {
-                                            strcat(allDeviceString, words[h]);
-                                            strcat(allDeviceString, " ");
-                                        }
-                                        if (isNextDay == 0)
-                                        {
-                                            fprintf(fp, "%-12s%-7s%2s:00                %-13s%s\n", words[2], words[3], endTimeString, words[0], allDeviceString);
-                                        }
-                                        else 
-                                        {
-                                            fprintf(fp, "%-12s%-7s%2s:00(the next day)  %-13s%s\n", words[2], words[3], endTimeString, words[0], allDeviceString);
-                                        }
-                                    }
-                                    free(words);
-                                }
-                                fprintf(fp, "\n");
+                                reportString(&report, "\n\n");
                             }
-                            fprintf(fp, "\n\n");
+                            const policySchedule *schedule = &shared->schedules[i];
+                            printSchedule(&report, policies[i].title, schedule, bookings, numOfCommand);
                         }
 
-                        if (printPRIO == 1)
+                        // clean up
+                        if (!reportClose(&report))
                         {
-                            // print all accepted bookings
-                            fprintf(fp, "*** Room Booking - ACCEPTED / Priority ***\n");
-                            for (i = 0; i < tenantAmount; i++)
-                            {
-                                fprintf(fp, "%s has the following bookings:\n", tenantNames[i]);
-                                fprintf(fp, "Date        Start  End                  Type         Room     Device           \n");
-                                fprintf(fp, "=================================================================\n");
-                                for (u = 0; u < numOfCommand; u++)
-                                {
-                                    strcpy(room, "XXX");
-                                    rejected = 0;
-                                    for (h = 0; h < priorityRejectedCount; h++)
-                                    {
-                                        if (priorityRejectedCommandIndex[h] == u)
-                                        {
-                                            rejected = 1;
-                                            break;
-                                        }
-                                    }
-                                    if (rejected == 0)
-                                    {
-                                        numOfWords = getNumOfWord(commandHistory[u], strlen(commandHistory[u]));
-                                        char **words = splitCommand(commandHistory[u], strlen(commandHistory[u]));
-                                        words[1]++;
-                                        // for (i = 0; i < numOfWords; i++) {
-                                        //     printf("Output: word[%d] = %s\n", i, words[i]);
-                                        // }
-                                        startTime[0] = words[3][0];
-                                        startTime[1] = words[3][1];
-                                        startTime[2] = 0;
-                                        duration = getIntFromString(words[4]);
-                                        //printf("Output: duration of [%s] is %d\n", words[4], duration);
-                                        startTimeInt = getIntFromString(startTime);
-                                        //printf("Output: start time of [%s] is %d\n", startTime, startTimeInt);
-                                        endtime = getIntFromString(startTime) + duration;
-                                        if (endtime > 23)
-                                        {
-                                            isNextDay = 1;
-                                            endtime = endtime - 24;
-                                        }
-                                        else
-                                        {
-                                            isNextDay = 0;
-                                        }
-                                        //printf("Output: end time is %d\n", endtime);
-                                        endTimeString = getStringFromInt(endtime);
-                                        if (strcmp(words[0], "bookDevice") == 0)
-                                        {
-                                            needFindRoom = 0;
-                                            deviceIndexStart = 5;
-                                            strcpy(words[0], "*");
-                                        }
-                                        else
-                                        {
-                                            needFindRoom = 1;
-                                            deviceIndexStart = 6;
-                                            words[0] = words[0] + 3;
-                                        }
-                                        // format devices string
-                                        allDeviceString[0] = 0;
-                                        for (h = deviceIndexStart; h < numOfWords; h++)
-                                        {
-                                            strcat(allDeviceString, words[h]);
-                                            strcat(allDeviceString, " ");
-                                        }
-
-                                        // finding the room
-                                        // search for each room (with suitable room size)
-                                        // check if the time slot (from start to end) is occupied by the tanent
-                                        h = 0;
-                                        int r, q, isOnThatDay;
-                                        participant = getIntFromString(words[5]);
-                                        if (needFindRoom == 1)
-                                        {
-                                            // printf("Output: checking rooms (prio) for command %d\n", u);
-                                            while (h < SCHEDULE_STRING_LENGTH)
-                                            {
-                                                memcpy(tempDate, &prioSchedule[h], 10);
-                                                tempDate[10] = '\0';
-                                                // check if date is the same
-                                                //printf("Output: checking date: %s vs %s\n", tempDate, words[2]);
-                                                if (strcmp(tempDate, words[2]) == 0)
-                                                {
-                                                    // find each room and check availability
-                                                    //printf("Output: found same date: %s\n", tempDate);
-                                                    for (r = 0; r < roomAmount; r++)
-                                                    {
-                                                        if (roomCapacity[r] >= participant)
-                                                        {
-                                                            //printf("Output: found room with good size: %s\n", roomNames[r]);
-                                                            int tempStart = h + 10 + r * 24 + startTimeInt;
-                                                            isOnThatDay = 1;
-                                                            char t = i + '0';
-                                                            for (q = 0; q < duration; q++)
-                                                            {
-                                                                if (prioSchedule[tempStart + q] != t)
-                                                                {
-                                                                    isOnThatDay = 0;
-                                                                    break;
-                                                                }
-                                                            }
-                                                            if (isOnThatDay == 1)
-                                                            {
-                                                                strcpy(room, roomNames[r]);
-                                                                break;
-                                                            }
-                                                        }
-                                                    }
-                                                }
-                                                h = h + oneDayScheduleSize;
-                                            }
-                                        }
-                                        else
-                                        {
-                                            strcpy(room, "*");
-                                        }
-
-                                        if (strcmp(words[1], tenantNames[i]) == 0)
-                                        {
-                                            if (isNextDay == 0)
-                                            {
-                                                fprintf(fp, "%-12s%-7s%2s:00                %-13s%-9s%s\n", words[2], words[3], endTimeString, words[0], room, allDeviceString);
-                                            }
-                                            else
-                                            {
-                                                fprintf(fp, "%-12s%-7s%2s:00(the next day)  %-13s%-9s%s\n", words[2], words[3], endTimeString, words[0], room, allDeviceString);
-                                            }
-                                        }
-                                        free(words);
-                                    }
-                                }
-                                fprintf(fp, "\n");
-                            }
-                            fprintf(fp, "\n");
-
-                            // print all rejected command
-                            fprintf(fp, "*** Room Booking - REJECTED / Priority ***\n");
-                            for (i = 0; i < tenantAmount; i++)
-                            {
-                                fprintf(fp, "%s has the following bookings:\n", tenantNames[i]);
-                                fprintf(fp, "Date        Start  End                  Type         Device           \n");
-                                fprintf(fp, "=================================================================\n");
-                                for (u = 0; u < priorityRejectedCount; u++)
-                                {
-                                    char currentCmd[COMMAND_CHAR_SIZE];
-                                    strcpy(currentCmd, commandHistory[priorityRejectedCommandIndex[u]]);
-                                    numOfWords = getNumOfWord(currentCmd, strlen(currentCmd));
-                                    char **words = splitCommand(currentCmd, strlen(currentCmd));
-                                    words[1]++;
-                                    //printf("Output: comparing %s to %s\n", words[1], tenantNames[i]);
-                                    if (strcmp(words[1], tenantNames[i]) == 0)
-                                    {
-                                        startTime[0] = words[3][0];
-                                        startTime[1] = words[3][1];
-                                        startTime[2] = 0;
-                                        duration = getIntFromString(words[4]);
-                                        //printf("Output: duration of [%s] is %d\n", words[4], duration);
-                                        startTimeInt = getIntFromString(startTime);
-                                        //printf("Output: start time of [%s] is %d\n", startTime, startTimeInt);
-                                        endtime = getIntFromString(startTime) + duration;
-                                        if (endtime > 23)
-                                        {
-                                            isNextDay = 1;
-                                            endtime = endtime - 24;
-                                        }
-                                        else
-                                        {
-                                            isNextDay = 0;
-                                        }
-                                        //printf("Output: end time is %d\n", endtime);
-                                        endTimeString = getStringFromInt(endtime);
-                                        if (strcmp(words[0], "bookDevice") == 0)
-                                        {
-                                            deviceIndexStart = 5;
-                                            strcpy(words[0], "*");
-                                        }
-                                        else
-                                        {
-                                            deviceIndexStart = 6;
-                                            words[0] = words[0] + 3;
-                                        }
-                                        allDeviceString[0] = 0;
-                                        for (h = deviceIndexStart; h < numOfWords; h++)
-                                        {
-                                            strcat(allDeviceString, words[h]);
-                                            strcat(allDeviceString, " ");
-                                        }
-                                        if (isNextDay == 0)
-                                        {
-                                            fprintf(fp, "%-12s%-7s%2s:00                %-13s%s\n", words[2], words[3], endTimeString, words[0], allDeviceString);
-                                        }
-                                        else 
-                                        {
-                                            fprintf(fp, "%-12s%-7s%2s:00(the next day)  %-13s%s\n", words[2], words[3], endTimeString, words[0], allDeviceString);
-                                        }
-                                        
-                                    }
-                                    free(words);
-                                }
-                                fprintf(fp, "\n");
-                            }
+                            printf("Output module Error, error in writing\n");
                         }
-
-                        // clean up
-                        free(endTimeString);
-                        fclose(fp);
-                        fcfsRejectedCount = 0;
-                        priorityRejectedCount = 0;
                         numOfCommand = 0;
-                        fcfsSchedule[0] = 0;
-                        prioSchedule[0] = 0;
+                        // tell parent the schedules are no longer read
+                        sendMessage(outputPipe[1][1], MSG_END, NULL, 0);
                     }
-                    else
+                    else if (type == MSG_PRINT)
                     {
-                        strcpy(mode, buf);
-                        while (1)
-                        {
-                            n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            if (strcmp(buf, "&&") != 0)
-                            {
-                                strcpy(commandHistory[numOfCommand], buf);
-                                numOfCommand++;
-                            }
-                            else
-                            {
-                                break;
-                            }
-                        }
-                        if (strcmp(mode, "-fcfs") == 0)
-                        {
-                            n = read(outputPipe[0][0], fcfsSchedule, SCHEDULE_STRING_LENGTH);
-                            fcfsSchedule[n] = 0;
-                            n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            fcfsRejectedCount = getIntFromString(buf);
-                            for (i = 0; i < fcfsRejectedCount; i++)
-                            {
-                                n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                                buf[n] = 0;
-                                fcfsRejectedCommandIndex[i] = getIntFromString(buf);
-                            }
-                        }
-                        else if (strcmp(mode, "-prio") == 0)
-                        {
-                            n = read(outputPipe[0][0], prioSchedule, SCHEDULE_STRING_LENGTH);
-                            prioSchedule[n] = 0;
-                            n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            priorityRejectedCount = getIntFromString(buf);
-                            for (i = 0; i < priorityRejectedCount; i++)
-                            {
-                                n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                                buf[n] = 0;
-                                priorityRejectedCommandIndex[i] = getIntFromString(buf);
-                            }
-                        }
-                        else if (strcmp(mode, "-ALL") == 0)
-                        {
-                            n = read(outputPipe[0][0], fcfsSchedule, SCHEDULE_STRING_LENGTH);
-                            fcfsSchedule[n] = 0;
-                            n = read(outputPipe[0][0], prioSchedule, SCHEDULE_STRING_LENGTH);
-                            prioSchedule[n] = 0;
-                            n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            fcfsRejectedCount = getIntFromString(buf);
-                            n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            priorityRejectedCount = getIntFromString(buf);
-                            for (i = 0; i < fcfsRejectedCount; i++)
-                            {
-                                n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                                buf[n] = 0;
-                                fcfsRejectedCommandIndex[i] = getIntFromString(buf);
-                            }
-                            for (i = 0; i < priorityRejectedCount; i++)
-                            {
-                                n = read(outputPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                                buf[n] = 0;
-                                priorityRejectedCommandIndex[i] = getIntFromString(buf);
-                            }
-                        }
+                        // a new printBookings, the command history follows
+                        policyMask = buf.length == sizeof(policyMask) ? *(unsigned int *)buf.data : 0;
+                        numOfCommand = 0;
+                    }
+                    else if (type == MSG_BOOKING && buf.length == 2 * sizeof(int))
+                    {
+                        // the bookings to print are in the store
+                        int *range = (int *)buf.data;
+                        numOfCommand = range[0] + range[1];
                     }
                 }
+                free(buf.data);
+                free(report.buf);
 
                 // use outputPipe[1][1] to WRITE TO PARENT
                 // use outputPipe[0][0] to READ FROM PARENT
@@ -2259,213 +5204,121 @@ int main()
                     close(analyzerPipe[0][1]);
                     // printf("Analyzer Module: started.\n");
 
-                    int n;
-                    char buf[COMMAND_CHAR_SIZE];
+                    messageBuffer buf = {NULL, 0, 0};
 
                     // -- Useful Data --
-                    char fcfsSchedule[SCHEDULE_STRING_LENGTH + 1];
-                    char prioSchedule[SCHEDULE_STRING_LENGTH + 1];
-                    int numOfCommand;
-                    int fcfsRejectedAmount;
-                    int priorityRejectedAmount;
-                    int invalidCommandAmount;
+                    int numOfCommand = 0;
+                    int invalidCommandAmount = 0;
+                    unsigned int policyMask = 0;
+                    reportWriter report = {-1, NULL, 0, 0};
 
                     while (1)
                     {
-                        n = read(analyzerPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                        buf[n] = 0;
-                        // printf("Analyzer module: received [%s]\n", buf);
+                        int type = receiveMessage(analyzerPipe[0][0], &buf);
+                        // printf("Analyzer module: received type %d\n", type);
                         // whole program is finish, end child
-                        if (strcmp(buf, "CLOSE") == 0)
+                        if (type < 0 || type == MSG_CLOSE)
                         {
                             // printf("analyzer module: closing...\n");
                             break;
                         }
-                        else if (strcmp(buf, "END") == 0)
+                        else if (type == MSG_END)
                         {
-                            // printf("Analyzer: received fcfs = %s\n", fcfsSchedule);
-                            // printf("Analyzer: received prio = %s\n", prioSchedule);
-                            // printf("Analyzer: received numOfCommand = %d\n", numOfCommand);
-                            // printf("Analyzer: received fcfsRejecteAmount = %d\n", fcfsRejectedAmount);
-                            // printf("Analyzer: received priorityRejecteAmount = %d\n", priorityRejectedAmount);
-                            // printf("Analyzer: received invalidCommandAmount = %d\n", invalidCommandAmount);
-                            // -- write it here
-
-                            int fcfsAssignedAmount = numOfCommand - fcfsRejectedAmount;
-                            int priorityAssignedAmount = numOfCommand - priorityRejectedAmount;
-
-                            int fcfsRoomsUnused[roomAmount];
-                            int fcfsWebcamsUnused[webcamAmount];
-                            int fcfsMonitorsUnused[monitorAmount];
-                            int fcfsProjectorsUnused[projectorAmount];
-                            int fcfsScreensUnused[screenAmount];
-                            int prioRoomsUnused[roomAmount];
-                            int prioWebcamsUnused[webcamAmount];
-                            int prioMonitorsUnused[monitorAmount];
-                            int prioProjectorsUnused[projectorAmount];
-                            int prioScreensUnused[screenAmount];
-
-                            int currentUnused, a, day, hr;
-                            int count = 0;
-                            for (currentUnused = 0; currentUnused < 5; currentUnused++)
+                            // the payload is the generation of the schedules to analyze
+                            if (buf.length != sizeof(unsigned int) || *(unsigned int *)buf.data != shared->generation)
                             {
-                                for (a = 0; a < 3; a++)
-                                {
-                                    for (day = 0; day < 7; day++)
-                                    {
-                                        for (hr = 0; hr < 24; hr++)
-                                        {
-                                            if (fcfsSchedule[360 * day + 10 * (day + 1) + 72 * currentUnused + 24 * a + hr] == '_')
-                                            {
-                                                count++;
-                                                switch (currentUnused)
-                                                {
-                                                case 0:
-                                                    fcfsRoomsUnused[a]++;
-                                                    break;
-                                                case 1:
-                                                    fcfsWebcamsUnused[a]++;
-                                                    break;
-                                                case 2:
-                                                    fcfsMonitorsUnused[a]++;
-                                                    break;
-                                                case 3:
-                                                    fcfsProjectorsUnused[a]++;
-                                                    break;
-                                                case 4:
-                                                    fcfsScreensUnused[a]++;
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                    }
-                                }
+                                printf("Analyzer module Error, schedules are not published\n");
+                                sendMessage(analyzerPipe[1][1], MSG_END, NULL, 0);
+                                continue;
                             }
-                            //printf("%d,", count);
-                            for (currentUnused = 0; currentUnused < 5; currentUnused++)
+                            // the period is from the first day to the last day of the bookings
+                            int firstDay = 0, lastDay = -1, i;
+                            for (i = 0; i < numOfCommand; i++)
                             {
-                                for (a = 0; a < 3; a++)
+                                int endDay = bookings[i].day + (bookings[i].startMinute + bookings[i].duration - 1) / (DAY_HOURS * 60);
+                                if (i == 0 || bookings[i].day < firstDay)
                                 {
-                                    for (day = 0; day < 7; day++)
-                                    {
-                                        for (hr = 0; hr < 24; hr++)
-                                        {
-                                            if (prioSchedule[360 * day + 10 * (day + 1) + 72 * currentUnused + 24 * a + hr] == '_')
-                                            {
-                                                switch (currentUnused)
-                                                {
-                                                case 0:
-                                                    prioRoomsUnused[a]++;
-                                                    break;
-                                                case 1:
-                                                    prioWebcamsUnused[a]++;
-                                                    break;
-                                                case 2:
-                                                    prioMonitorsUnused[a]++;
-                                                    break;
-                                                case 3:
-                                                    prioProjectorsUnused[a]++;
-                                                    break;
-                                                case 4:
-                                                    prioScreensUnused[a]++;
-                                                    break;
-                                                }
-                                            }
-                                        }
-                                    }
+                                    firstDay = bookings[i].day;
+                                }
+                                if (i == 0 || endDay > lastDay)
+                                {
+                                    lastDay = endDay;
                                 }
                             }
+                            int days = lastDay - firstDay + 1;
 
-                            FILE *fp;
-                            fp = fopen(DIRECTORY_ANALYSIS_REPORT, "w");
-                            fprintf(fp, "*** Room Booking Manager - Summary Report ***\n\n");
-                            fprintf(fp, "Performance:\n\n");
-                            fprintf(fp, "  For FCFS:\n");
-                            fprintf(fp, "            Total Number of Booking Received: %d (%0.1f%%)\n", numOfCommand, (float)numOfCommand / numOfCommand * 100);
-                            fprintf(fp, "                  Number of Booking Assigned: %d (%0.1f%%)\n", fcfsAssignedAmount, (float)fcfsAssignedAmount / numOfCommand * 100);
-                            fprintf(fp, "                  Number of Booking Rejected: %d (%0.1f%%)\n\n", fcfsRejectedAmount, (float)fcfsRejectedAmount / numOfCommand * 100);
-                            fprintf(fp, "            Utilization of Time Slot:\n");
-
-                            int z;
-
-                            for (z = 0; z < 3; z++)
+                            // the selected schedules, in the order of policies
+                            utilization usage[policyAmount];
+                            int rejectedAmount[policyAmount];
+                            // the bookings standing, without the cancellations and the bookings cancelled or moved
+                            int received[policyAmount];
+                            const char *names[policyAmount];
+                            int scheduleCount = 0, failed = 0;
+                            for (i = 0; i < policyAmount && !failed; i++)
                             {
-                                fprintf(fp, "                  %s         - %0.1f%%\n", roomNames[z], (float)(168 - fcfsRoomsUnused[z]) / 168 * 100);
-                            }
-                            for (z = 0; z < 3; z++)
-                            {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", webcamNames[z], (float)(168 - fcfsWebcamsUnused[z]) / 168 * 100);
+                                if (!(policyMask & (1u << i)))
+                                {
+                                    continue;
+                                }
+                                if (!utilizationCompute(&usage[scheduleCount], &shared->schedules[i].cal, firstDay, days))
+                                {
+                                    failed = 1;
+                                    break;
+                                }
+                                rejectedAmount[scheduleCount] = shared->schedules[i].rejectedCount;
+                                received[scheduleCount] = numOfCommand - shared->schedules[i].withdrawn;
+                                names[scheduleCount] = policies[i].label;
+                                scheduleCount++;
                             }
-                            for (z = 0; z < 3; z++)
+                            if (failed || !reportOpen(&report, DIRECTORY_ANALYSIS_REPORT))
                             {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", monitorNames[z], (float)(168 - fcfsMonitorsUnused[z]) / 168 * 100);
+                                printf(failed ? "Analyzer module Error, out of memory\n" : "Analyzer module Error, error in opening\n");
+                                for (i = 0; i < scheduleCount; i++)
+                                {
+                                    free(usage[i].dayHours);
+                                }
+                                sendMessage(analyzerPipe[1][1], MSG_END, NULL, 0);
+                                continue;
                             }
-                            for (z = 0; z < 3; z++)
+                            reportString(&report, "*** Room Booking Manager - Summary Report ***\n\n");
+                            reportString(&report, "Performance:\n\n");
+                            for (i = 0; i < scheduleCount; i++)
                             {
-                                fprintf(fp, "                  %s   - %0.1f%%\n", projectorNames[z], (float)(168 - fcfsProjectorsUnused[z]) / 168 * 100);
+                                if (i > 0)
+                                {
+                                    reportString(&report, "\n");
+                                }
+                                printAnalysis(&report, names[i], &usage[i], received[i], rejectedAmount[i], invalidCommandAmount);
                             }
-                            for (z = 0; z < 3; z++)
+                            reportString(&report, "\n");
+                            printComparison(&report, names, usage, rejectedAmount, received, scheduleCount);
+                            for (i = 0; i < scheduleCount; i++)
                             {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", screenNames[z], (float)(168 - fcfsScreensUnused[z]) / 168 * 100);
+                                free(usage[i].dayHours);
                             }
-                            fprintf(fp, "\n            Invalid request(s) made: %d\n", invalidCommandAmount);
-
-                            fprintf(fp, "\n");
 
-                            fprintf(fp, "  For PRIO:\n");
-                            fprintf(fp, "            Total Number of Booking Received: %d (%0.1f%%)\n", numOfCommand, (float)numOfCommand / numOfCommand * 100);
-                            fprintf(fp, "                  Number of Booking Assigned: %d (%0.1f%%)\n", priorityAssignedAmount, (float)priorityAssignedAmount / numOfCommand * 100);
-                            fprintf(fp, "                  Number of Booking Rejected: %d (%0.1f%%)\n\n", priorityRejectedAmount, (float)priorityRejectedAmount / numOfCommand * 100);
-                            fprintf(fp, "            Utilization of Time Slot:\n");
-                            for (z = 0; z < 3; z++)
-                            {
-                                fprintf(fp, "                  %s         - %0.1f%%\n", roomNames[z], (float)(168 - prioRoomsUnused[z]) / 168 * 100);
-                            }
-                            for (z = 0; z < 3; z++)
-                            {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", webcamNames[z], (float)(168 - prioWebcamsUnused[z]) / 168 * 100);
-                            }
-                            for (z = 0; z < 3; z++)
-                            {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", monitorNames[z], (float)(168 - prioMonitorsUnused[z]) / 168 * 100);
-                            }
-                            for (z = 0; z < 3; z++)
-                            {
-                                fprintf(fp, "                  %s   - %0.1f%%\n", projectorNames[z], (float)(168 - prioProjectorsUnused[z]) / 168 * 100);
-                            }
-                            for (z = 0; z < 3; z++)
+                            if (!reportClose(&report))
                             {
-                                fprintf(fp, "                  %s     - %0.1f%%\n", screenNames[z], (float)(168 - prioScreensUnused[z]) / 168 * 100);
+                                printf("Analyzer module Error, error in writing\n");
                             }
-                            fprintf(fp, "\n            Invalid request(s) made: %d\n", invalidCommandAmount);
-
-                            fclose(fp);
+                            // tell parent the schedules are no longer read
+                            sendMessage(analyzerPipe[1][1], MSG_END, NULL, 0);
 
                             // main objectives:
-                            // 1. analyze all schedule from fcfsSchedule and prioSchedule
+                            // 1. analyze all the selected schedules
                             // using to -- USEFUL DATA --
                             // 2. print the fucking report to a file
                         }
-                        else if (strcmp(buf, "START") == 0)
+                        else if (type == MSG_SUMMARY)
                         {
-                            n = read(analyzerPipe[0][0], fcfsSchedule, SCHEDULE_STRING_LENGTH);
-                            fcfsSchedule[n] = 0;
-                            n = read(analyzerPipe[0][0], prioSchedule, SCHEDULE_STRING_LENGTH);
-                            prioSchedule[n] = 0;
-                            n = read(analyzerPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            numOfCommand = getIntFromString(buf);
-                            n = read(analyzerPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            fcfsRejectedAmount = getIntFromString(buf);
-                            n = read(analyzerPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            priorityRejectedAmount = getIntFromString(buf);
-                            n = read(analyzerPipe[0][0], buf, COMMAND_CHAR_SIZE);
-                            buf[n] = 0;
-                            invalidCommandAmount = getIntFromString(buf);
+                            int *summary = (int *)buf.data;
+                            numOfCommand = summary[0];
+                            invalidCommandAmount = summary[1];
+                            policyMask = (unsigned int)summary[2];
                         }
                     }
+                    free(buf.data);
+                    free(report.buf);
 
                     close(analyzerPipe[1][1]);
                     close(analyzerPipe[0][0]);
@@ -2477,241 +5330,136 @@ int main()
                     close(analyzerPipe[1][1]);
                     close(analyzerPipe[0][0]);
                     // Parent: receive input
-                    int n;
-                    char commandHistory[MAX_COMMAND][COMMAND_CHAR_SIZE];
-                    int numOfCommand = 0;
+                    int numOfCommand = replayed;
                     int invalidCount = 0;
-                    char buf[COMMAND_CHAR_SIZE];
+                    messageBuffer buf = {NULL, 0, 0};
+                    // 0 while the input module streams a batch file
+                    int prompt = 1;
+                    if (replayed > restored)
+                    {
+                        // the bookings of the log after the snapshot are placed first
+                        int range[2] = {restored, replayed - restored};
+                        sendMessage(schedulePipe[0][1], MSG_BOOKING, range, sizeof(range));
+                    }
 
                     while (1)
                     {
-                        write(inputPipe[0][1], "PROMPT", COMMAND_CHAR_SIZE);
+                        // the daemon reads its clients without being prompted
+                        if (prompt == 1 && socketPath == NULL)
+                        {
+                            sendMessage(inputPipe[0][1], MSG_PROMPT, NULL, 0);
+                        }
 
-                        n = read(inputPipe[1][0], buf, COMMAND_CHAR_SIZE);
-                        buf[n] = 0;
-                        // printf("Parent: %d char read from pipe: [%s]\n", n, buf);
-                        if (strcmp(buf, "endProgram;") == 0)
+                        int type = receiveMessage(inputPipe[1][0], &buf);
+                        // printf("Parent: message type %d read from pipe: [%s]\n", type, buf.data);
+                        if (type < 0 || type == MSG_END_PROGRAM)
                         {
                             // printf("Parent: end program command is received.\n");
                             break;
                         }
-                        else if (strcmp(buf, "INVALID") == 0)
+                        else if (type == MSG_INVALID)
+                        {
+                            invalidCount += buf.length == sizeof(int) ? *(int *)buf.data : 1;
+                        }
+                        else if (type == MSG_BATCH_START)
                         {
-                            invalidCount++;
+                            prompt = 0;
                         }
-                        else
+                        else if (type == MSG_END)
                         {
-                            char **words = splitCommand(buf, n);
-                            int numOfWords = getNumOfWord(buf, n);
-                            if (strcmp(words[0], "printBookings") == 0)
+                            // end of the batch file
+                            prompt = 1;
+                        }
+                        else if (type == MSG_PRINT)
+                        {
+                            unsigned int policyMask = 0;
+                            memcpy(&policyMask, buf.data, buf.length == sizeof(policyMask) ? sizeof(policyMask) : 0);
+
+                            // ask scheduling module to publish the schedules
+                            // the bookings are already placed as they arrived
+                            sendMessage(schedulePipe[0][1], MSG_PRINT, &policyMask, sizeof(policyMask));
+                            unsigned int generation = 0;
+                            while ((type = receiveMessage(schedulePipe[1][0], &buf)) != MSG_END && type >= 0)
+                                ;
+                            if (type == MSG_END && buf.length == sizeof(generation))
                             {
-                                // start scheduling module
-                                write(schedulePipe[0][1], words[1], COMMAND_CHAR_SIZE);
-                                for (i = 0; i < numOfCommand; i++)
-                                {
-                                    write(schedulePipe[0][1], commandHistory[i], COMMAND_CHAR_SIZE);
-                                }
-                                write(schedulePipe[0][1], "END", COMMAND_CHAR_SIZE);
-
-                                char bigBuf[SCHEDULE_STRING_LENGTH];
-                                int g;
-                                // get schedule from schedule module
-                                g = read(schedulePipe[1][0], bigBuf, SCHEDULE_STRING_LENGTH);
-                                bigBuf[g] = 0;
-                                // printf("Parent: %d char read from schedule pipe: [%s]\n", g, bigBuf);
-                                // saved to result!
-                                if (strcmp(words[1], "-fcfs") == 0)
-                                {
-                                    strcpy(fcfs, bigBuf);
-                                    n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                    buf[n] = 0;
-                                    fcfsRejectedCount = strtol(buf, NULL, 10);
-                                    if (fcfsRejectedCount > 0)
-                                    {
-                                        for (i = 0; i < fcfsRejectedCount; i++)
-                                        {
-                                            n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                            buf[n] = 0;
-                                            fcfsRejectedCommandIndex[i] = strtol(buf, NULL, 10);
-                                        }
-                                    }
-                                    // printf("Parent: current fcfs = %s\n", fcfs);
-                                    // printf("Parent: current fcfsRejectedCount = %d\n", fcfsRejectedCount);
-                                    // printf("Parent: current fcfsRejectedCommandIndex = [");
-                                    // for (i = 0; i < fcfsRejectedCount; i++)
-                                    // {
-                                    //     printf("%d, ", fcfsRejectedCommandIndex[i]);
-                                    // }
-                                    // printf("]\n");
-                                }
-                                else if (strcmp(words[1], "-prio") == 0)
-                                {
-                                    strcpy(priority, bigBuf);
-                                    n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                    buf[n] = 0;
-                                    priorityRejectedCount = strtol(buf, NULL, 10);
-                                    if (priorityRejectedCount > 0)
-                                    {
-                                        for (i = 0; i < priorityRejectedCount; i++)
-                                        {
-                                            n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                            buf[n] = 0;
-                                            priorityRejectedCommandIndex[i] = strtol(buf, NULL, 10);
-                                        }
-                                    }
-                                    // printf("Parent: current priority = %s\n", priority);
-                                    // printf("Parent: current priorityRejectedCount = %d\n", priorityRejectedCount);
-                                    // printf("Parent: current priorityRejectedCommandIndex = [");
-                                    // for (i = 0; i < priorityRejectedCount; i++)
-                                    // {
-                                    //     printf("%d, ", priorityRejectedCommandIndex[i]);
-                                    // }
-                                    // printf("]\n");
-                                }
-                                else if (strcmp(words[1], "-ALL") == 0)
-                                {
-                                    strcpy(fcfs, bigBuf);
-                                    g = read(schedulePipe[1][0], bigBuf, SCHEDULE_STRING_LENGTH);
-                                    bigBuf[g] = 0;
-                                    strcpy(priority, bigBuf);
-                                    n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                    buf[n] = 0;
-                                    fcfsRejectedCount = strtol(buf, NULL, 10);
-                                    if (fcfsRejectedCount > 0)
-                                    {
-                                        for (i = 0; i < fcfsRejectedCount; i++)
-                                        {
-                                            n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                            buf[n] = 0;
-                                            fcfsRejectedCommandIndex[i] = strtol(buf, NULL, 10);
-                                        }
-                                    }
-                                    // printf("Parent: current fcfs = %s\n", fcfs);
-                                    // printf("Parent: current fcfsRejectedCount = %d\n", fcfsRejectedCount);
-                                    // printf("Parent: current fcfsRejectedCommandIndex = [");
-                                    // for (i = 0; i < fcfsRejectedCount; i++)
-                                    // {
-                                    //     printf("%d, ", fcfsRejectedCommandIndex[i]);
-                                    // }
-                                    // printf("]\n");
-                                    n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                    buf[n] = 0;
-                                    if (strcmp(buf, "&&") == 0)
-                                    {
-                                        n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                        buf[n] = 0;
-                                        priorityRejectedCount = strtol(buf, NULL, 10);
-                                        if (priorityRejectedCount > 0)
-                                        {
-                                            for (i = 0; i < priorityRejectedCount; i++)
-                                            {
-                                                n = read(schedulePipe[1][0], buf, COMMAND_CHAR_SIZE);
-                                                buf[n] = 0;
-                                                priorityRejectedCommandIndex[i] = strtol(buf, NULL, 10);
-                                            }
-                                        }
-                                        // printf("Parent: current priority = %s\n", priority);
-                                        // printf("Parent: current priorityRejectedCount = %d\n", priorityRejectedCount);
-                                        // printf("Parent: current priorityRejectedCommandIndex = [");
-                                        // for (i = 0; i < priorityRejectedCount; i++)
-                                        // {
-                                        //     printf("%d, ", priorityRejectedCommandIndex[i]);
-                                        // }
-                                        // printf("]\n");
-                                    }
-                                }
+                                memcpy(&generation, buf.data, sizeof(generation));
+                            }
 
-                                // send to output module
-                                char *temp;
-                                write(outputPipe[0][1], words[1], COMMAND_CHAR_SIZE);
-                                for (i = 0; i < numOfCommand; i++)
-                                {
-                                    write(outputPipe[0][1], commandHistory[i], COMMAND_CHAR_SIZE);
-                                }
-                                write(outputPipe[0][1], "&&", COMMAND_CHAR_SIZE);
-                                if (strcmp(words[1], "-fcfs") == 0)
-                                {
-                                    write(outputPipe[0][1], fcfs, SCHEDULE_STRING_LENGTH);
-                                    temp = getStringFromInt(fcfsRejectedCount);
-                                    write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    for (i = 0; i < fcfsRejectedCount; i++)
-                                    {
-                                        temp = getStringFromInt(fcfsRejectedCommandIndex[i]);
-                                        write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    }
-                                }
-                                else if (strcmp(words[1], "-prio") == 0)
-                                {
-                                    write(outputPipe[0][1], priority, SCHEDULE_STRING_LENGTH);
-                                    temp = getStringFromInt(priorityRejectedCount);
-                                    write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    for (i = 0; i < priorityRejectedCount; i++)
-                                    {
-                                        temp = getStringFromInt(priorityRejectedCommandIndex[i]);
-                                        write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    }
-                                }
-                                else if (strcmp(words[1], "-ALL") == 0)
-                                {
-                                    write(outputPipe[0][1], fcfs, SCHEDULE_STRING_LENGTH);
-                                    write(outputPipe[0][1], priority, SCHEDULE_STRING_LENGTH);
-                                    temp = getStringFromInt(fcfsRejectedCount);
-                                    write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    temp = getStringFromInt(priorityRejectedCount);
-                                    write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    for (i = 0; i < fcfsRejectedCount; i++)
-                                    {
-                                        temp = getStringFromInt(fcfsRejectedCommandIndex[i]);
-                                        write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    }
-                                    for (i = 0; i < priorityRejectedCount; i++)
-                                    {
-                                        temp = getStringFromInt(priorityRejectedCommandIndex[i]);
-                                        write(outputPipe[0][1], temp, COMMAND_CHAR_SIZE);
-                                    }
-                                }
-                                free(temp);
-                                write(outputPipe[0][1], "END", COMMAND_CHAR_SIZE);
+                            // send to output module, it reads the schedules from the shared region
+                            int range[2] = {0, numOfCommand};
+                            message outputMessages[] = {
+                                {MSG_PRINT, &policyMask, sizeof(policyMask)},
+                                {MSG_BOOKING, range, sizeof(range)},
+                                {MSG_END, &generation, sizeof(generation)},
+                            };
+                            sendMessages(outputPipe[0][1], outputMessages, 3);
 
-                                // send to analyze module
-                                if (strcmp(words[1], "-ALL") == 0)
-                                {
-                                    char *n = getStringFromInt(numOfCommand);
-                                    char *f = getStringFromInt(fcfsRejectedCount);
-                                    char *p = getStringFromInt(priorityRejectedCount);
-                                    char *i = getStringFromInt(invalidCount);
-                                    write(analyzerPipe[0][1], "START", COMMAND_CHAR_SIZE);
-                                    write(analyzerPipe[0][1], fcfs, SCHEDULE_STRING_LENGTH);
-                                    write(analyzerPipe[0][1], priority, SCHEDULE_STRING_LENGTH);
-                                    write(analyzerPipe[0][1], n, COMMAND_CHAR_SIZE);
-                                    write(analyzerPipe[0][1], f, COMMAND_CHAR_SIZE);
-                                    write(analyzerPipe[0][1], p, COMMAND_CHAR_SIZE);
-                                    write(analyzerPipe[0][1], i, COMMAND_CHAR_SIZE);
-                                    write(analyzerPipe[0][1], "END", COMMAND_CHAR_SIZE);
-                                    free(n);
-                                    free(f);
-                                    free(p);
-                                    free(i);
-                                }
-                                printf("-> [Done!]\n");
+                            // send to analyze module, when there are schedules to compare
+                            int analyze = __builtin_popcount(policyMask) > 1;
+                            if (analyze)
+                            {
+                                int summary[3] = {numOfCommand, invalidCount, (int)policyMask};
+                                message analyzerMessages[] = {
+                                    {MSG_SUMMARY, summary, sizeof(summary)},
+                                    {MSG_END, &generation, sizeof(generation)},
+                                };
+                                sendMessages(analyzerPipe[0][1], analyzerMessages, 2);
                             }
-                            else
+
+                            // wait until they finish reading, the next booking changes the schedules
+                            while ((type = receiveMessage(outputPipe[1][0], &buf)) != MSG_END && type >= 0)
+                                ;
+                            if (analyze)
+                            {
+                                while ((type = receiveMessage(analyzerPipe[1][0], &buf)) != MSG_END && type >= 0)
+                                    ;
+                            }
+                            printf("-> [Done!]\n");
+                            if (socketPath != NULL)
+                            {
+                                // the daemon replies to the client of the printBookings
+                                sendMessage(inputPipe[0][1], MSG_END, NULL, 0);
+                            }
+                        }
+                        else if (type == MSG_BOOKING)
+                        {
+                            // addBooking, addPresentation, addConference, or bookDevice
+                            // one booking, or a chunk of a batch file, already in the store
+                            int *range = (int *)buf.data;
+                            if (buf.length != sizeof(int) * 2 || range[0] != numOfCommand)
+                            {
+                                printf("Parent: unexpected booking range\n");
+                                continue;
+                            }
+                            int count = range[1];
+                            numOfCommand += count;
+                            // scheduling module places them now, printBookings only collects the result
+                            sendMessage(schedulePipe[0][1], MSG_BOOKING, range, buf.length);
+                            if (socketPath != NULL)
+                            {
+                                // the daemon has replied to its clients
+                            }
+                            else if (prompt && count == 1 && admit)
+                            {
+                                // the input module has printed the answer of the line, a batch file gets none
+                            }
+                            else if (prompt && count == 1)
                             {
-                                // addBooking, addPresentation, addConference, or bookDevice
-                                // record the input history
-                                strcpy(commandHistory[numOfCommand], buf);
-                                //printf("Parent: saved %d:[%s]\n", numOfCommand, commandHistory[numOfCommand]);
-                                numOfCommand++;
                                 printf("-> [Pending]\n");
                             }
-                            free(words);
+                            else
+                            {
+                                printf("-> [Pending: %d bookings]\n", count);
+                            }
                         }
                     }
+                    free(buf.data);
 
                     // clean up
-                    write(schedulePipe[0][1], "CLOSE", COMMAND_CHAR_SIZE);
-                    write(outputPipe[0][1], "CLOSE", COMMAND_CHAR_SIZE);
-                    write(analyzerPipe[0][1], "CLOSE", COMMAND_CHAR_SIZE);
+                    sendMessage(schedulePipe[0][1], MSG_CLOSE, NULL, 0);
+                    sendMessage(outputPipe[0][1], MSG_CLOSE, NULL, 0);
+                    sendMessage(analyzerPipe[0][1], MSG_CLOSE, NULL, 0);
 
                     close(inputPipe[1][0]);
                     close(inputPipe[0][1]);